@@ -1,8 +1,12 @@
 #include "TEventDisplay.hxx"
 #include "TEventChangeManager.hxx"
+#include "TEventIndex.hxx"
+#include "TEventChain.hxx"
+#include "TTimingTable.hxx"
 
 #include <TCaptLog.hxx>
 #include <TRootInput.hxx>
+#include <TRuntimeParameters.hxx>
 #include <TVInputFile.hxx>
 
 #include <TROOT.h>
@@ -13,11 +17,39 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
 
 void usage() {
-    std::cout << "Usage: event-display.exe [input-file] " << std::endl;
+    std::cout << "Usage: event-display.exe [input-file] ..." << std::endl;
     std::cout << "    The event display: " << std::endl;
+    std::cout << "    More than one input file can be given (and file names"
+              << std::endl
+              << "    can contain wildcards) to show the files as a single"
+              << std::endl
+              << "    stream of events." << std::endl;
     std::cout << "  -g    Toggle showing the geometry." << std::endl;
+    std::cout << "  -e <run>.<event>" << std::endl
+              << "        Start at the run and event number." << std::endl;
+    std::cout << "  -f, --follow" << std::endl
+              << "        Follow a file that is still being written and show"
+              << std::endl
+              << "        the newest event.  New events are only seen after"
+              << std::endl
+              << "        the writer saves the tree header (TTree::AutoSave),"
+              << std::endl
+              << "        so the writer should call AutoSave after each event"
+              << std::endl
+              << "        (see follow-writer.exe)." << std::endl;
+    std::cout << "  -s <selection>" << std::endl
+              << "        Only show events passing a selection (e.g. hits>=100,"
+              << std::endl
+              << "        track>500, or pmt>1000)." << std::endl;
+    std::cout << "  -t, --timing <file>" << std::endl
+              << "        Collect the time spent drawing each event, and write"
+              << std::endl
+              << "        it to a CSV file as each event is finished."
+              << std::endl;
     std::cout << "  -c    Set the log configuration file." << std::endl;
     std::cout << "  -d    Increase the debug level"
               << std::endl;
@@ -34,20 +66,41 @@ void usage() {
 }
 
 int main(int argc, char **argv) {
-    std::string fileName = "";
+    std::vector<std::string> fileNames;
     bool showGeometry = false;
+    std::string startEvent = "";
+    std::string skimSelection = "";
+    bool follow = false;
+    std::string timingFile = "";
     int debugLevel = 0;
     std::map<std::string, CP::TCaptLog::ErrorPriority> namedDebugLevel;
     int logLevel = -1; // Will choose default logging level...
     std::map<std::string, CP::TCaptLog::LogPriority> namedLogLevel;
     char *configName = NULL;
+    static struct option longOptions[] = {
+        {"follow", no_argument, NULL, 'f'},
+        {"timing", required_argument, NULL, 't'},
+        {NULL, 0, NULL, 0}
+    };
     while (1) {
-        int c = getopt(argc, argv, "?hgdD:vV:c:");
+        int c = getopt_long(argc, argv, "?hgdD:vV:c:e:s:ft:", longOptions, NULL);
         if (c == -1) break;
         switch (c) {
         case 'g': // Show the geometry.
             showGeometry = not showGeometry;
             break;
+        case 'e': // Start at a run and event.
+            startEvent = optarg;
+            break;
+        case 's': // Skim the events.
+            skimSelection = optarg;
+            break;
+        case 'f': // Follow a file that is being written.
+            follow = true;
+            break;
+        case 't': // Write the timing to a file.
+            timingFile = optarg;
+            break;
         case 'c': {
             configName = strdup(optarg);
             break;
@@ -174,14 +227,25 @@ int main(int argc, char **argv) {
         CP::TCaptLog::SetDebugLevel(i->first.c_str(), i->second);
     }
          
-    // Check if there is an input file on the command line.
-    if (argc - optind > 0) {
-        fileName = argv[optind];
+    // Check if there are input files on the command line.
+    for (int i = optind; i < argc; ++i) {
+        CP::TEventChain::ExpandFileName(argv[i], fileNames);
     }
 
     CP::TVInputFile* eventSource = NULL;
-    if (!fileName.empty()) {
-        eventSource = new CP::TRootInput(fileName.c_str());
+    CP::TEventIndex* eventIndex = NULL;
+    if (fileNames.size() == 1) {
+        CP::TRootInput* rootInput 
+            = new CP::TRootInput(fileNames.front().c_str());
+        // A file that is still being written isn't indexed since the index
+        // would be out of date as soon as it was finished.
+        if (!follow) eventIndex = new CP::TEventIndex(rootInput);
+        eventSource = rootInput;
+    }
+    else if (fileNames.size() > 1) {
+        int openFiles = CP::TRuntimeParameters::Get().GetParameterI(
+            "eventDisplay.chain.openFiles");
+        eventSource = new CP::TEventChain(fileNames, openFiles);
     }
     if (!eventSource) {
         usage();
@@ -189,12 +253,49 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    // Find the first entry to show.  If the file has an index sidecar, this
+    // is immediate, otherwise, the display starts at the first entry and
+    // goes to the event when the index finds it.
+    int firstEntry = 0;
+    int startRun = -1;
+    int startEventNumber = -1;
+    bool startPending = false;
+    if (!startEvent.empty() && !eventIndex) {
+        CaptError("Starting at an event needs a single input file"
+                  << " (and can't be used with --follow)");
+    }
+    else if (!startEvent.empty()) {
+        if (!CP::TEventIndex::ParseEventName(startEvent,
+                                             startRun, startEventNumber)) {
+            usage();
+            CaptError("Invalid start event: " << startEvent);
+            return 1;
+        }
+        firstEntry = eventIndex->GetEntry(startRun, startEventNumber);
+        if (firstEntry < 0) {
+            startPending = true;
+            firstEntry = 0;
+        }
+    }
+
     TApplication theApp("EventDisplay", 0, 0);
     theApp.ExitOnException(TApplication::kExit);
 
     CP::TEventDisplay& ev = CP::TEventDisplay::Get();
     ev.EventChange().SetShowGeometry(showGeometry);
-    ev.EventChange().SetEventSource(eventSource);
+    if (!timingFile.empty()) {
+        ev.Timing().SetCSVFile(timingFile);
+        ev.EventChange().SetTiming(true);
+    }
+    ev.EventChange().SetEventIndex(eventIndex);
+    ev.EventChange().SetEventSource(eventSource, firstEntry);
+    if (startPending) {
+        ev.EventChange().GotoEvent(startRun, startEventNumber);
+    }
+    if (!skimSelection.empty()) {
+        ev.EventChange().StartSkim(skimSelection.c_str());
+    }
+    if (follow) ev.EventChange().SetFollow(true);
 
     theApp.Run(kFALSE);
 
@@ -0,0 +1,89 @@
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <TRootInput.hxx>
+#include <TRootOutput.hxx>
+
+#include <TSystem.h>
+#include <TTree.h>
+
+#include <getopt.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+void usage() {
+    std::cout << "Usage: follow-writer.exe [options] input-file output-file"
+              << std::endl;
+    std::cout << "    Copy the events to a file that can be followed by the"
+              << std::endl
+              << "    event display (event-display.exe -f output-file)."
+              << std::endl;
+    std::cout << "  -p <milliseconds>" << std::endl
+              << "        The time between events (default 1000)."
+              << std::endl;
+    std::cout << "  -n <count>" << std::endl
+              << "        The number of events to copy (default all)."
+              << std::endl;
+}
+
+/// Save the header of each tree in the output file.  The reader only sees
+/// the entries that are in the last saved header (see TTree::AutoSave() and
+/// TTree::Refresh()).
+void SaveTrees(CP::TRootOutput* output) {
+    TIter next(output->GetList());
+    while (TObject* obj = next()) {
+        TTree* tree = dynamic_cast<TTree*>(obj);
+        if (tree) tree->AutoSave("SaveSelf");
+    }
+}
+
+/// Copy the events in a file to a new file slowly, and save the tree header
+/// after each event so that the output can be shown with "event-display
+/// --follow" while it is being written.  This is the same thing a DAQ (or a
+/// simulation job) writing a file needs to do to be followed.
+int main(int argc, char **argv) {
+    int period = 1000;
+    int count = -1;
+    while (1) {
+        int c = getopt(argc, argv, "?hp:n:");
+        if (c == -1) break;
+        switch (c) {
+        case 'p':
+            period = std::atoi(optarg);
+            break;
+        case 'n':
+            count = std::atoi(optarg);
+            break;
+        case '?':
+        case 'h':
+        default:
+            usage();
+            return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        usage();
+        return 1;
+    }
+
+    CP::TRootInput input(argv[optind]);
+    CP::TRootOutput* output = new CP::TRootOutput(argv[optind+1], "NEW");
+    int entries = input.GetEventsInFile();
+    if (count < 0 || count > entries) count = entries;
+    for (int entry = 0; entry < count; ++entry) {
+        CP::TEvent* event = input.ReadEvent(entry);
+        if (!event) {
+            CaptError("Unable to read entry " << entry);
+            continue;
+        }
+        output->WriteEvent(*event);
+        SaveTrees(output);
+        CaptLog("Wrote " << event->GetContext());
+        delete event;
+        gSystem->Sleep(period);
+    }
+    output->Close();
+    delete output;
+    return 0;
+}
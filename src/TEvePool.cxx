@@ -0,0 +1,130 @@
+#include "TEvePool.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <TEveManager.h>
+#include <TEveElement.h>
+#include <TEveLine.h>
+#include <TEveBoxSet.h>
+
+#include <algorithm>
+
+CP::TEvePool::TEvePool(int maximum)
+    : fMaximum(std::max(0,maximum)) {}
+
+CP::TEvePool::~TEvePool() {
+    for (std::map<std::string, std::vector<TEveElement*> >::iterator f
+             = fFree.begin();
+         f != fFree.end(); ++f) {
+        for (std::vector<TEveElement*>::iterator e = f->second.begin();
+             e != f->second.end(); ++e) {
+            Delete(*e);
+        }
+    }
+}
+
+int CP::TEvePool::GetFreeCount() const {
+    int count = 0;
+    for (std::map<std::string, std::vector<TEveElement*> >::const_iterator f
+             = fFree.begin();
+         f != fFree.end(); ++f) {
+        count += f->second.size();
+    }
+    return count;
+}
+
+void CP::TEvePool::Release(TEveElement* list) {
+    if (!list) return;
+    std::vector<TEveElement*> pooled;
+    for (TEveElement::List_i c = list->BeginChildren();
+         c != list->EndChildren(); ++c) {
+        Collect(*c, pooled);
+    }
+
+    // The pooled elements have a deny destroy count, so this only destroys
+    // the elements that didn't come from the pool.
+    list->RemoveElements();
+
+    for (std::vector<TEveElement*>::iterator e = pooled.begin();
+         e != pooled.end(); ++e) {
+        // A pooled element might have been inside another element that was
+        // just destroyed, or it might still be in another list.
+        if ((*e)->NumParents() > 0) continue;
+        const std::string& type = fOwned[*e];
+        fFree[type].push_back(*e);
+        --fInUse[type];
+    }
+}
+
+void CP::TEvePool::Trim() {
+    int trimmed = 0;
+    for (std::map<std::string, std::vector<TEveElement*> >::iterator f
+             = fFree.begin();
+         f != fFree.end(); ++f) {
+        const std::string& type = f->first;
+        std::size_t keep = std::min(fPeak[type], fMaximum);
+        while (f->second.size() > keep) {
+            TEveElement* element = f->second.back();
+            f->second.pop_back();
+            fOwned.erase(element);
+            Delete(element);
+            ++trimmed;
+        }
+        fPeak[type] = fInUse[type];
+    }
+    if (trimmed > 0) {
+        CaptInfo("Element pool trimmed " << trimmed << " elements, "
+                 << fOwned.size() << " remaining");
+    }
+}
+
+TEveElement* CP::TEvePool::Take(const std::string& type) {
+    int& inUse = ++fInUse[type];
+    fPeak[type] = std::max(fPeak[type], inUse);
+    std::vector<TEveElement*>& free = fFree[type];
+    if (free.empty()) return NULL;
+    TEveElement* element = free.back();
+    free.pop_back();
+    return element;
+}
+
+void CP::TEvePool::Adopt(TEveElement* element, const std::string& type) {
+    // Keep the element from being destroyed when it's removed from a list.
+    element->IncDenyDestroy();
+    fOwned[element] = type;
+}
+
+void CP::TEvePool::Collect(TEveElement* element,
+                           std::vector<TEveElement*>& pooled) {
+    if (fOwned.find(element) != fOwned.end()) pooled.push_back(element);
+    for (TEveElement::List_i c = element->BeginChildren();
+         c != element->EndChildren(); ++c) {
+        Collect(*c, pooled);
+    }
+}
+
+void CP::TEvePool::Delete(TEveElement* element) {
+    element->DecDenyDestroy();
+    gEve->PreDeleteElement(element);
+    delete element;
+}
+
+void CP::TEvePool::ResetElement(TEveLine* element) {
+    element->Reset(0);
+    element->SetName("");
+    element->SetTitle("");
+    element->SetLineStyle(1);
+    element->SetLineWidth(1);
+    element->SetRnrSelf(kTRUE);
+    // The GL viewer keeps the display list of an element until it's
+    // stamped, so a reused element would be drawn with its old points.
+    element->StampObjProps();
+}
+
+void CP::TEvePool::ResetElement(TEveBoxSet* element) {
+    element->Reset(TEveBoxSet::kBT_AABox, kTRUE, 128);
+    element->SetName("");
+    element->SetTitle("");
+    element->SetRnrSelf(kTRUE);
+    element->StampObjProps();
+}
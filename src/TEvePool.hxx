@@ -0,0 +1,100 @@
+#ifndef TEvePool_hxx_seen
+#define TEvePool_hxx_seen
+
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace CP {
+    class TEvePool;
+};
+
+class TEveElement;
+class TEveLine;
+class TEveBoxSet;
+
+/// A pool of Eve elements that are reused between events instead of being
+/// deleted and allocated again.  The elements are kept separately for each
+/// type.  The event change handlers get the elements that they draw with
+/// Get<T>() (instead of new), and return all of the pooled elements below
+/// one of their lists with Release() (instead of DestroyElements()).
+/// Elements that didn't come from the pool are destroyed by Release() as
+/// usual.  After each event, Trim() deletes the free elements that weren't
+/// needed, so the pool only keeps as many elements of a type as the busiest
+/// recent event needed (up to a maximum).
+///
+/// Only elements that can be completely reset are pooled (currently
+/// TEveLine and TEveBoxSet).  The pool is owned by CP::TEventDisplay and is
+/// accessed through CP::TEventDisplay::Pool().  It must only be used on the
+/// main thread.
+class CP::TEvePool {
+public:
+    /// Create a pool that keeps at most "maximum" free elements of a type.
+    explicit TEvePool(int maximum);
+    ~TEvePool();
+
+    /// Get an element from the pool (or a new one if the pool is empty).  A
+    /// reused element is reset to an empty element with default drawing
+    /// attributes, but the caller must set the name, title and color.
+    template <class T> T* Get() {
+        T* element = static_cast<T*>(Take(typeid(T).name()));
+        if (element) {
+            ResetElement(element);
+            return element;
+        }
+        element = new T;
+        Adopt(element, typeid(T).name());
+        return element;
+    }
+
+    /// Remove all of the children from the list.  The pooled elements
+    /// (including any that are nested inside other children) are returned
+    /// to the pool, and the other children are destroyed.
+    void Release(TEveElement* list);
+
+    /// Delete the free elements that weren't needed since the last trim.
+    void Trim();
+
+    /// Get the number of elements of all types made by the pool.
+    int GetElementCount() const {return fOwned.size();}
+
+    /// Get the number of free elements of all types.
+    int GetFreeCount() const;
+
+private:
+    /// Take a free element of a type from the pool.  This returns NULL if
+    /// there isn't one.
+    TEveElement* Take(const std::string& type);
+
+    /// Add a new element to the pool.
+    void Adopt(TEveElement* element, const std::string& type);
+
+    /// Find the pooled elements below an element.
+    void Collect(TEveElement* element, std::vector<TEveElement*>& pooled);
+
+    /// Delete an element made by the pool.
+    void Delete(TEveElement* element);
+
+    /// Reset an element for reuse.  The element is stamped as changed so
+    /// that the GL viewer doesn't draw its cached display list.
+    static void ResetElement(TEveLine* element);
+    static void ResetElement(TEveBoxSet* element);
+
+    /// The maximum number of free elements kept for a type.
+    int fMaximum;
+
+    /// The type of every element made by the pool.
+    std::map<TEveElement*, std::string> fOwned;
+
+    /// The free elements for each type.
+    std::map<std::string, std::vector<TEveElement*> > fFree;
+
+    /// The number of elements of each type that are in use.
+    std::map<std::string, int> fInUse;
+
+    /// The largest number of elements of each type in use since the last
+    /// trim.
+    std::map<std::string, int> fPeak;
+};
+#endif
@@ -0,0 +1,157 @@
+#include "TEventCache.hxx"
+
+#include "TEventSummary.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <TDigitContainer.hxx>
+#include <TDigit.hxx>
+#include <THitSelection.hxx>
+#include <TReconBase.hxx>
+#include <TG4HitSegment.hxx>
+#include <TG4Trajectory.hxx>
+#include <TG4TrajectoryPoint.hxx>
+#include <THandle.hxx>
+
+#include <TClass.h>
+
+CP::TEventCache::TEventCache(Long64_t budget)
+    : fBudget(budget), fBytes(0) {}
+
+CP::TEventCache::~TEventCache() {
+    if (!fRecords.empty()) {
+        CaptError("Event cache deleted with " << fRecords.size()
+                  << " events");
+    }
+}
+
+Long64_t CP::TEventCache::GetDatumBytes(CP::TDatum* datum) {
+    if (!datum) return 0;
+    Long64_t bytes = datum->IsA()->Size();
+
+    CP::TDataVector* dv = dynamic_cast<CP::TDataVector*>(datum);
+    if (dv) {
+        for (CP::TDataVector::iterator d = dv->begin(); d != dv->end(); ++d) {
+            bytes += GetDatumBytes(*d);
+        }
+        return bytes;
+    }
+
+    // The digits are usually the largest part of an event, and most of
+    // their memory is in the samples.
+    CP::TDigitContainer* digits = dynamic_cast<CP::TDigitContainer*>(datum);
+    if (digits) {
+        for (CP::TDigitContainer::iterator d = digits->begin();
+             d != digits->end(); ++d) {
+            if (!(*d)) continue;
+            bytes += (*d)->IsA()->Size()
+                + sizeof(float)*CP::TEventSummary::GetDigitSampleCount(*d);
+        }
+        return bytes;
+    }
+
+    CP::THitSelection* hits = dynamic_cast<CP::THitSelection*>(datum);
+    if (hits) {
+        for (CP::THitSelection::iterator h = hits->begin();
+             h != hits->end(); ++h) {
+            bytes += sizeof(*h) + (*h)->IsA()->Size();
+        }
+        return bytes;
+    }
+
+    CP::TReconObjectContainer* objects
+        = dynamic_cast<CP::TReconObjectContainer*>(datum);
+    if (objects) {
+        for (CP::TReconObjectContainer::iterator o = objects->begin();
+             o != objects->end(); ++o) {
+            bytes += sizeof(*o) + (*o)->IsA()->Size();
+        }
+        return bytes;
+    }
+
+    CP::TG4HitContainer* g4Hits = dynamic_cast<CP::TG4HitContainer*>(datum);
+    if (g4Hits) {
+        for (CP::TG4HitContainer::iterator h = g4Hits->begin();
+             h != g4Hits->end(); ++h) {
+            if (*h) bytes += (*h)->IsA()->Size();
+        }
+        return bytes;
+    }
+
+    CP::TG4TrajectoryContainer* trajectories
+        = dynamic_cast<CP::TG4TrajectoryContainer*>(datum);
+    if (trajectories) {
+        for (CP::TG4TrajectoryContainer::iterator t = trajectories->begin();
+             t != trajectories->end(); ++t) {
+            bytes += sizeof(CP::TG4Trajectory)
+                + sizeof(CP::TG4TrajectoryPoint)
+                *t->second.GetTrajectoryPoints().size();
+        }
+        return bytes;
+    }
+
+    return bytes;
+}
+
+Long64_t CP::TEventCache::GetEventBytes(CP::TEvent& event) {
+    return GetDatumBytes(&event);
+}
+
+void CP::TEventCache::Insert(int entry, CP::TEvent* event, Long64_t bytes,
+                             const std::vector<std::string>& pruned,
+                             std::vector<CP::TEvent*>& evicted) {
+    if (!event) return;
+    if (bytes > fBudget) {
+        evicted.push_back(event);
+        return;
+    }
+
+    // Replace an old copy of the entry.
+    std::map<int, Record>::iterator old = fRecords.find(entry);
+    if (old != fRecords.end()) {
+        evicted.push_back(old->second.event);
+        fBytes -= old->second.bytes;
+        fUses.erase(old->second.use);
+        fRecords.erase(old);
+    }
+
+    // Make room by removing the least recently used events.
+    while (!fUses.empty() && fBytes + bytes > fBudget) {
+        std::map<int, Record>::iterator last = fRecords.find(fUses.back());
+        evicted.push_back(last->second.event);
+        fBytes -= last->second.bytes;
+        fUses.pop_back();
+        fRecords.erase(last);
+    }
+
+    fUses.push_front(entry);
+    Record& record = fRecords[entry];
+    record.event = event;
+    record.bytes = bytes;
+    record.pruned = pruned;
+    record.use = fUses.begin();
+    fBytes += bytes;
+}
+
+CP::TEvent* CP::TEventCache::Take(int entry, Long64_t& bytes,
+                                  std::vector<std::string>& pruned) {
+    std::map<int, Record>::iterator record = fRecords.find(entry);
+    if (record == fRecords.end()) return NULL;
+    CP::TEvent* event = record->second.event;
+    bytes = record->second.bytes;
+    pruned = record->second.pruned;
+    fBytes -= record->second.bytes;
+    fUses.erase(record->second.use);
+    fRecords.erase(record);
+    return event;
+}
+
+void CP::TEventCache::Clear(std::vector<CP::TEvent*>& evicted) {
+    for (std::map<int, Record>::iterator r = fRecords.begin();
+         r != fRecords.end(); ++r) {
+        evicted.push_back(r->second.event);
+    }
+    fRecords.clear();
+    fUses.clear();
+    fBytes = 0;
+}
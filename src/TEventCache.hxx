@@ -0,0 +1,94 @@
+#ifndef TEventCache_hxx_seen
+#define TEventCache_hxx_seen
+
+#include <Rtypes.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TEventCache;
+    class TEvent;
+    class TDatum;
+};
+
+/// A least recently used cache of decoded events with a memory budget.  The
+/// CP::TEventPrefetch puts the events that drop out of its ring into the
+/// cache, so going back to an event that was looked at recently doesn't
+/// reread and decode it.  When the events in the cache use more than the
+/// budget, the least recently used events are removed.  The size of each
+/// event is estimated from the objects that are left in it after the
+/// folders that aren't needed have been removed (see GetEventBytes()).
+///
+/// \note This is not thread safe.  The CP::TEventPrefetch protects it with
+/// its own lock.  The cache never deletes an event.  Events that are removed
+/// are handed back to the caller so that they can be deleted while holding
+/// the CP::TEventPrefetch::GetEventLock() lock.
+class CP::TEventCache {
+public:
+    /// Create a cache that holds at most "budget" bytes of events.
+    explicit TEventCache(Long64_t budget);
+    ~TEventCache();
+
+    /// Estimate the memory used by an event.  This adds up the class sizes
+    /// of the objects in the folders that are still in the event, plus the
+    /// samples of the digits, so the event doesn't need to be streamed, and
+    /// the folders removed by CP::TEventPrefetch aren't counted.  The caller
+    /// must hold the event lock.
+    static Long64_t GetEventBytes(CP::TEvent& event);
+
+    /// Add an event to the cache, and take ownership of it.  The pruned
+    /// folders are the folders that have been removed from the event (see
+    /// CP::TEventPrefetch::SetEventPaths()).  The events that are pushed
+    /// out of the cache (including this event if it is larger than the
+    /// budget) are added to evicted, and must be deleted by the caller.
+    void Insert(int entry, CP::TEvent* event, Long64_t bytes,
+                const std::vector<std::string>& pruned,
+                std::vector<CP::TEvent*>& evicted);
+
+    /// Take an event out of the cache, and return it (the caller takes
+    /// ownership).  This returns NULL if the entry isn't in the cache.
+    CP::TEvent* Take(int entry, Long64_t& bytes,
+                     std::vector<std::string>& pruned);
+
+    /// Remove all of the events from the cache.  The events are added to
+    /// evicted, and must be deleted by the caller.
+    void Clear(std::vector<CP::TEvent*>& evicted);
+
+    /// Get the memory budget in bytes.
+    Long64_t GetBudget() const {return fBudget;}
+
+    /// Get the estimated memory used by the events in the cache.
+    Long64_t GetBytes() const {return fBytes;}
+
+    /// Get the number of events in the cache.
+    int GetEventCount() const {return fRecords.size();}
+
+private:
+    /// Estimate the memory used by a datum and everything inside of it.
+    static Long64_t GetDatumBytes(CP::TDatum* datum);
+
+    /// The information saved for each event.
+    struct Record {
+        CP::TEvent* event;
+        Long64_t bytes;
+        std::vector<std::string> pruned;
+        /// The position of the entry in fUses.
+        std::list<int>::iterator use;
+    };
+
+    /// The cached events indexed by entry number.
+    std::map<int, Record> fRecords;
+
+    /// The cached entry numbers with the most recently used first.
+    std::list<int> fUses;
+
+    /// The memory budget.
+    Long64_t fBudget;
+
+    /// The estimated memory used by the cached events.
+    Long64_t fBytes;
+};
+#endif
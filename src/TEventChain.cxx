@@ -0,0 +1,200 @@
+#include "TEventChain.hxx"
+#include "TEventIndex.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <TEventContext.hxx>
+#include <TEventFolder.hxx>
+#include <TRootInput.hxx>
+
+#include <TSystem.h>
+#include <TString.h>
+#include <TRegexp.h>
+
+#include <algorithm>
+
+CP::TEventChain::TEventChain(const std::vector<std::string>& fileNames,
+                             int maxOpenFiles)
+    : fFileNames(fileNames), fMaxOpenFiles(std::max(1,maxOpenFiles)),
+      fEntryCount(0), fPosition(-1), fPositionFile(-1) {
+    fInputs.resize(fFileNames.size(), NULL);
+
+    // Build the global index.  The number of entries in each file comes from
+    // the index sidecar if it exists, otherwise, the file is opened.
+    fFirstEntries.push_back(0);
+    for (std::size_t i = 0; i < fFileNames.size(); ++i) {
+        int entries = CP::TEventIndex::GetSidecarEntryCount(fFileNames[i]);
+        if (entries < 0) {
+            CP::TRootInput* input = GetInput(i);
+            if (input) entries = input->GetEventsInFile();
+            if (entries > 0) fUnindexed.push_back(i);
+        }
+        if (entries < 0) entries = 0;
+        CaptLog("Chain " << fFileNames[i] << " with " << entries
+                << " entries");
+        fEntryCount += entries;
+        fFirstEntries.push_back(fEntryCount);
+    }
+}
+
+CP::TEventChain::~TEventChain() {
+    CloseFile();
+}
+
+void CP::TEventChain::ExpandFileName(const std::string& pattern,
+                                     std::vector<std::string>& fileNames) {
+    if (pattern.find_first_of("*?") == std::string::npos) {
+        fileNames.push_back(pattern);
+        return;
+    }
+
+    TString dirName(gSystem->DirName(pattern.c_str()));
+    TString baseName(gSystem->BaseName(pattern.c_str()));
+    TRegexp wildcard(baseName, kTRUE);
+
+    void* dir = gSystem->OpenDirectory(dirName);
+    if (!dir) {
+        CaptError("Cannot read directory " << dirName);
+        return;
+    }
+    std::vector<std::string> found;
+    bool hidden = baseName.BeginsWith(".");
+    while (const char* entry = gSystem->GetDirEntry(dir)) {
+        TString name(entry);
+        if (!hidden && name.BeginsWith(".")) continue;
+        Ssiz_t length = 0;
+        if (wildcard.Index(name, &length) != 0) continue;
+        if (length != name.Length()) continue;
+        found.push_back(std::string(dirName.Data()) + "/" + entry);
+    }
+    gSystem->FreeDirectory(dir);
+
+    std::sort(found.begin(), found.end());
+    if (found.empty()) CaptError("No files match " << pattern);
+    fileNames.insert(fileNames.end(), found.begin(), found.end());
+}
+
+const char* CP::TEventChain::GetInputName() const {
+    if (fFileNames.empty()) return "";
+    return fFileNames.front().c_str();
+}
+
+bool CP::TEventChain::FindEntry(int entry, int& file, int& fileEntry) const {
+    if (entry < 0 || entry >= fEntryCount) return false;
+    std::vector<int>::const_iterator next
+        = std::upper_bound(fFirstEntries.begin(), fFirstEntries.end(), entry);
+    file = (next - fFirstEntries.begin()) - 1;
+    fileEntry = entry - fFirstEntries[file];
+    return true;
+}
+
+CP::TRootInput* CP::TEventChain::GetInput(int file) {
+    if (file < 0 || file >= (int) fInputs.size()) return NULL;
+
+    if (fInputs[file]) {
+        // Move the file to the front of the list of open files.
+        fOpenFiles.remove(file);
+        fOpenFiles.push_front(file);
+        return fInputs[file];
+    }
+
+    CaptLog("Open " << fFileNames[file]);
+    CP::TRootInput* input = new CP::TRootInput(fFileNames[file].c_str());
+    if (!input->IsOpen()) {
+        CaptError("Cannot open " << fFileNames[file]);
+        delete input;
+        return NULL;
+    }
+    fInputs[file] = input;
+    fOpenFiles.push_front(file);
+
+    // Close the least recently used files.  The file that was just opened
+    // is at the front, so it is never closed.
+    while (fOpenFiles.size() > fMaxOpenFiles) {
+        int old = fOpenFiles.back();
+        fOpenFiles.pop_back();
+        CaptLog("Close " << fFileNames[old]);
+        delete fInputs[old];
+        fInputs[old] = NULL;
+    }
+
+    return input;
+}
+
+CP::TEvent* CP::TEventChain::ReadEvent(int entry) {
+    int file;
+    int fileEntry;
+    if (!FindEntry(entry, file, fileEntry)) return NULL;
+    CP::TRootInput* input = GetInput(file);
+    if (!input) return NULL;
+    CP::TEvent* event = input->ReadEvent(fileEntry);
+    if (!event) return NULL;
+    fPosition = entry;
+    fPositionFile = file;
+    return event;
+}
+
+CP::TEvent* CP::TEventChain::FirstEvent() {
+    return ReadEvent(0);
+}
+
+CP::TEvent* CP::TEventChain::NextEvent(int skip) {
+    return ReadEvent(fPosition + skip + 1);
+}
+
+CP::TEvent* CP::TEventChain::PreviousEvent(int skip) {
+    return ReadEvent(fPosition - skip - 1);
+}
+
+bool CP::TEventChain::IsOpen() {
+    return (fEntryCount > 0);
+}
+
+bool CP::TEventChain::EndOfFile() {
+    return (fPosition >= fEntryCount-1);
+}
+
+void CP::TEventChain::CloseFile() {
+    for (std::vector<CP::TRootInput*>::iterator i = fInputs.begin();
+         i != fInputs.end(); ++i) {
+        if (*i) delete (*i);
+        (*i) = NULL;
+    }
+    fOpenFiles.clear();
+}
+
+bool CP::TEventChain::IndexStep() {
+    if (fUnindexed.empty()) return false;
+    int file = fUnindexed.front();
+    int entry = fIndexEvents.size();
+    int entries = fFirstEntries[file+1] - fFirstEntries[file];
+    if (entry < entries) {
+        CP::TRootInput* input = GetInput(file);
+        CP::TEvent* event = input ? input->ReadEvent(entry) : NULL;
+        int run = -1;
+        int eventNumber = -1;
+        if (event) {
+            // The event isn't shown, so it's taken out of the event folder.
+            CP::TEventFolder* folder = CP::TEventFolder::GetEventFolder();
+            if (folder) folder->Remove(event);
+            run = event->GetContext().GetRun();
+            eventNumber = event->GetContext().GetEvent();
+            delete event;
+        }
+        fIndexEvents.push_back(std::make_pair(run, eventNumber));
+        return true;
+    }
+
+    if (CP::TEventIndex::WriteSidecar(fFileNames[file], fIndexEvents)) {
+        CaptLog("Wrote event index for " << fFileNames[file]);
+    }
+    fIndexEvents.clear();
+    fUnindexed.pop_front();
+    return !fUnindexed.empty();
+}
+
+TFile* CP::TEventChain::GetFilePointer() const {
+    if (fPositionFile < 0) return NULL;
+    if (!fInputs[fPositionFile]) return NULL;
+    return fInputs[fPositionFile]->GetFilePointer();
+}
@@ -0,0 +1,136 @@
+#ifndef TEventChain_hxx_seen
+#define TEventChain_hxx_seen
+
+#include <TVInputFile.hxx>
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace CP {
+    class TEventChain;
+    class TEvent;
+    class TRootInput;
+};
+
+class TFile;
+
+/// Present a list of input files (e.g. all of the subrun files for a run) as
+/// a single stream of events.  The chain keeps a global index of the entries
+/// so that an entry number in the chain can be mapped to a file and an entry
+/// in that file.  This means that Next/Previous, jumps, and the event
+/// prefetch cross file boundaries transparently.
+///
+/// The files are opened lazily when an entry in them is first read, and only
+/// a few files are kept open at a time.  When too many files are open, the
+/// least recently used file is closed.  The number of entries in each file is
+/// taken from the CP::TEventIndex sidecar when one is available, so the files
+/// don't need to be opened to build the global index.  The files without a
+/// sidecar are only opened to get the number of entries, and are then
+/// scanned one entry at a time by the CP::TEventPrefetch worker when it has
+/// nothing else to read (see IndexStep()), and the sidecar is written when
+/// the scan of a file is finished.
+///
+/// \note Like CP::TRootInput, this is not thread safe.  The caller must hold
+/// the CP::TEventPrefetch::GetEventLock() lock.
+class CP::TEventChain: public CP::TVInputFile {
+public:
+    /// Create a chain of files.  The maximum number of files that are kept
+    /// open at once is set by maxOpenFiles.
+    TEventChain(const std::vector<std::string>& fileNames, int maxOpenFiles);
+    virtual ~TEventChain();
+
+    /// Expand a file name that may contain shell wildcards ("*" and "?" in
+    /// the file part of the name) into a sorted list of existing files.  The
+    /// files are appended to the fileNames vector.  Like the shell, a
+    /// wildcard doesn't match hidden files (starting with ".") unless the
+    /// pattern starts with a ".".
+    static void ExpandFileName(const std::string& pattern,
+                               std::vector<std::string>& fileNames);
+
+    /// Return the name of the first file in the chain.
+    virtual const char* GetInputName() const;
+
+    /// Return the total number of entries in all of the files.
+    int GetEventsInFile() {return fEntryCount;}
+
+    /// Read an entry using the global entry number.  This returns NULL if
+    /// the entry can't be read.
+    CP::TEvent* ReadEvent(int entry);
+
+    /// Get the number of files in the chain.
+    int GetFileCount() const {return fFileNames.size();}
+
+    /// Get the file index and the entry number in that file for a global
+    /// entry number.  This returns false if the entry is out of range.
+    bool FindEntry(int entry, int& file, int& fileEntry) const;
+
+    /// Read the next entry of a file that doesn't have an index sidecar,
+    /// and write the sidecar when the file has been scanned.  This returns
+    /// false when every file has a sidecar.
+    bool IndexStep();
+
+    /// Read the first event in the chain.
+    virtual CP::TEvent* FirstEvent();
+
+    /// Read the next event, skipping "skip" events.
+    virtual CP::TEvent* NextEvent(int skip=0);
+
+    /// Read the previous event, skipping "skip" events.
+    virtual CP::TEvent* PreviousEvent(int skip=0);
+
+    /// Get the global entry number of the last event read.
+    virtual int GetPosition(void) const {return fPosition;}
+
+    /// Check if any file in the chain can be read.
+    virtual bool IsOpen(void);
+
+    /// Check if the last event in the chain has been read.
+    virtual bool EndOfFile(void);
+
+    /// Close all of the files in the chain.
+    virtual void CloseFile(void);
+
+    /// Get the file containing the last event read.
+    virtual TFile* GetFilePointer(void) const;
+
+private:
+    /// Get the input for a file.  This opens the file if it isn't already
+    /// open, and closes the least recently used file if too many are open.
+    CP::TRootInput* GetInput(int file);
+
+    /// The names of the files in the chain.
+    std::vector<std::string> fFileNames;
+
+    /// The inputs for the files.  A file that isn't open is NULL.
+    std::vector<CP::TRootInput*> fInputs;
+
+    /// The global entry number of the first entry in each file.  This has
+    /// one more element than the number of files, and the last element is
+    /// the total number of entries.
+    std::vector<int> fFirstEntries;
+
+    /// The indices of the open files with the most recently used first.
+    std::list<int> fOpenFiles;
+
+    /// The maximum number of files to keep open.
+    std::size_t fMaxOpenFiles;
+
+    /// The total number of entries in the chain.
+    int fEntryCount;
+
+    /// The global entry number of the last event read.
+    int fPosition;
+
+    /// The file holding the last event read.
+    int fPositionFile;
+
+    /// The files that don't have an index sidecar.
+    std::list<int> fUnindexed;
+
+    /// The run and event numbers of the entries scanned in the first of the
+    /// unindexed files.
+    std::vector< std::pair<int,int> > fIndexEvents;
+};
+#endif
@@ -2,6 +2,22 @@
 #include "TVEventChangeHandler.hxx"
 #include "TGUIManager.hxx"
 #include "TEventDisplay.hxx"
+#include "TEventPrefetch.hxx"
+#include "TEventIndex.hxx"
+#include "TEventSkim.hxx"
+#include "TVSkimPredicate.hxx"
+#include "TTaskPool.hxx"
+#include "TVTask.hxx"
+#include "TTimingTable.hxx"
+#include "TScopedTimer.hxx"
+#include "TEvePool.hxx"
+#include "TEventSummary.hxx"
+#include "THandleCache.hxx"
+#include "TVJob.hxx"
+#include "TResultQueue.hxx"
+#include "TFrameBudget.hxx"
+#include "TGeometryCache.hxx"
+#include "TShapeFactory.hxx"
 
 #include <TEvent.hxx>
 #include <TEventFolder.hxx>
@@ -9,23 +25,86 @@
 #include <TManager.hxx>
 #include <TGeomIdManager.hxx>
 #include <TChannelInfo.hxx>
+#include <TRuntimeParameters.hxx>
 
 #include <TQObject.h>
 #include <TGButton.h>
+#include <TGNumberEntry.h>
+#include <TGTextEntry.h>
+#include <TGLabel.h>
+#include <TGListBox.h>
+#include <TTimer.h>
 #include <TGeoManager.h>
+#include <TSystem.h>
 #include <TGeoPgon.h>
 #include <TEveGeoShape.h>
 #include <TEveManager.h>
+#include <TEveScene.h>
+#include <TVirtualMutex.h>
 
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 ClassImp(CP::TEventChangeManager);
 
 namespace {
 
+    /// Call Commit() for a handler on the main thread.  This is posted to
+    /// the CP::TResultQueue when the Build() of the handler is finished.
+    class TCommitResult: public CP::TVTask {
+    public:
+        TCommitResult(CP::TVEventChangeHandler* handler,
+                      std::vector<CP::TVEventChangeHandler*>& committed)
+            : fHandler(handler), fCommitted(committed) {}
+        void Execute() {
+            CP::TScopedTimer timer(fHandler->GetName(), "::Commit");
+            fHandler->Commit();
+            fCommitted.push_back(fHandler);
+        }
+        std::string GetName() const {return fHandler->GetName();}
+    private:
+        CP::TVEventChangeHandler* fHandler;
+        std::vector<CP::TVEventChangeHandler*>& fCommitted;
+    };
+
+    /// Call Build() for a handler as a task in the CP::TTaskPool, and then
+    /// post the Commit() to the main thread.
+    class TBuildTask: public CP::TVTask {
+    public:
+        TBuildTask(CP::TVEventChangeHandler* handler, CP::TEvent* event,
+                   CP::TResultQueue& results,
+                   std::vector<CP::TVEventChangeHandler*>& committed)
+            : fHandler(handler), fEvent(event), fResults(results),
+              fCommitted(committed) {}
+        void Execute() {
+            {
+                CP::TScopedTimer timer(fHandler->GetName(), "::Build");
+                fHandler->SetBuildGroup(GetGroup());
+                fHandler->Build(*fEvent);
+                fHandler->SetBuildGroup(NULL);
+            }
+            if (IsCancelled()) return;
+            fResults.Post(new TCommitResult(fHandler, fCommitted));
+        }
+        std::string GetName() const {return fHandler->GetName();}
+    private:
+        CP::TVEventChangeHandler* fHandler;
+        CP::TEvent* fEvent;
+        CP::TResultQueue& fResults;
+        std::vector<CP::TVEventChangeHandler*>& fCommitted;
+    };
+
+    /// The clones of the geometry shapes indexed by the original shape.
+    /// Volumes with the same shape (e.g. the photosensors) share one clone,
+    /// and only the transformations are different.
+    typedef std::map<TGeoShape*, TGeoShape*> ShapeClones;
+
     /// This takes a geometry id and "clones" it into the Eve display.
-    TEveGeoShape* GeometryClone(CP::TGeometryId id) {
-        std::cout << id << " " << id.GetName() << std::endl;
+    TEveGeoShape* GeometryClone(CP::TGeometryId id, ShapeClones& clones) {
+        // The navigator might be in use by a worker thread.
+        TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
         if (!CP::TManager::Get().GeomId().CdId(id)) return NULL;
 
         TGeoNode* current = gGeoManager->GetCurrentNode();
@@ -33,69 +112,305 @@ namespace {
         TGeoShape* currShape = current->GetVolume()->GetShape();
 
         TEveGeoShape *fakeShape = new TEveGeoShape(id.GetName().c_str());
+
+        // The transformation is copied.
+        fakeShape->SetTransMatrix(*currMat);
+
+        // The shape is shared by the TEveGeoShape objects, which count
+        // the references (see TEveGeoShape::SetShape()), so it's deleted
+        // with the last one.
+        ShapeClones::iterator clone = clones.find(currShape);
+        if (clone != clones.end()) {
+            CP::TShapeFactory::SetShape(fakeShape, clone->second);
+            return fakeShape;
+        }
         
-        TGeoMatrix* mat = currMat->MakeClone();
-        fakeShape->SetTransMatrix(*mat);
-        
-        // Clone the shape so that it can be displayed.  This has to play some
-        // fancy footsie to get the gGeoManager memory management right.  It
-        // first saves the current manager, then gets an internal geometry
-        // manager used by TEveGeoShape, and then resets the old manager once
-        // the shape is created.
-        TGeoManager* saveGeom = gGeoManager;
-        gGeoManager = fakeShape->GetGeoMangeur();
-        TGeoShape* clonedShape 
-            = dynamic_cast<TGeoShape*> (currShape->Clone("fakeShape"));
-        fakeShape->SetShape(clonedShape);
-        gGeoManager = saveGeom;
+        // Clone the shape so that it can be displayed.
+        TGeoShape* clonedShape = CP::TShapeFactory::Clone(currShape);
+        CP::TShapeFactory::SetShape(fakeShape, clonedShape);
+        clones[currShape] = clonedShape;
         
         return fakeShape;
     }
 
-    /// This is called when a new geometry is loaded.  The implementation is
-    /// sloppy since it assumes it's only going to be called once.  That's
-    /// actually a reasonable assumption for the usual use case, but it should
-    /// probably be fixed.  The problem is that the TEveElementList is created
-    /// everytime this class is used.
+    /// This is called when a new geometry is loaded.  The simplified
+    /// geometry is kept in a single element in the global scene, and the
+    /// shapes of the old geometry are replaced when a new geometry is
+    /// loaded, so reading files with different geometries doesn't add to
+    /// the scene.
     class GeometryChangeCallback: public CP::TManager::GeometryChange {
     public:
+        GeometryChangeCallback()
+            : fCache(CP::TRuntimeParameters::Get().GetParameterS(
+                         "eventDisplay.geometry.cache")),
+              fSimple(NULL) {}
+
         void Callback(const CP::TEvent* const event) {
             CaptError("New geometry loaded " << gGeoManager);
 
+            // The values saved for the old geometry are found again when
+            // they are next used.
+            CP::TEventDisplay::Get().GeometryChanged();
+
             if (!CP::TEventDisplay::Get().EventChange().GetShowGeometry()) {
                 return;
             }
 
-            TEveElementList* simple = new TEveElementList("simplifiedGeometry");
+            if (!fSimple) {
+                // The element can't be destroyed from the GUI since it's
+                // reused for the next geometry.
+                fSimple = new TEveGeoShape("simplifiedGeometry");
+                fSimple->IncDenyDestroy();
+                gEve->AddGlobalElement(fSimple);
+            }
+            else {
+                // Remove the shapes of the old geometry.  The shared shapes
+                // are deleted with the last element that uses them, which
+                // changes gGeoManager (see CP::TShapeFactory).
+                TLockGuard guard(
+                    &CP::TVEventChangeHandler::GetGeometryLock());
+                fSimple->DestroyElements();
+            }
+
+            // The simplified geometry is read from the cache if this
+            // geometry has been seen before.  Otherwise, it's built from the
+            // geometry and saved for next time.
+            std::string hash;
+            if (fCache.IsEnabled()) {
+                hash = CP::TGeometryCache::GetGeometryHash();
+            }
+            if (!fCache.Load(hash, fSimple)) {
+                BuildSimplifiedGeometry(fSimple);
+                fCache.Save(hash, fSimple);
+            }
+
+            // The geometry is only redrawn when it changes.  This is the
+            // only place that the global scene is changed.
+            gEve->GetGlobalScene()->Changed();
+            CP::TEventDisplay::Get().EventChange().ResetCamera();
+        }
+
+    private:
+        /// Build the simplified geometry from the loaded geometry, and add
+        /// the shapes of the volumes that are shown to the parent.
+        void BuildSimplifiedGeometry(TEveElement* simple) {
+            CP::TScopedTimer timer("GeometryChangeCallback::Build");
+            ShapeClones clones;
 
             // Add the drift region.
-            TEveGeoShape *shape = GeometryClone(CP::GeomId::Captain::Drift());
-            shape->SetMainColor(kCyan);
-            shape->SetMainTransparency(80);
-            simple->AddElement(shape);
+            TEveGeoShape *shape
+                = GeometryClone(CP::GeomId::Captain::Drift(), clones);
+            if (shape) {
+                shape->SetMainColor(kCyan);
+                shape->SetMainTransparency(80);
+                simple->AddElement(shape);
+            }
 
             // Add the pmts.  There are up to about 24, but this has a large
             // limit so that it catches any expansions.
             for (int i=0; i<200; ++i) {
-                shape = GeometryClone(CP::GeomId::Captain::Photosensor(i));
+                shape = GeometryClone(CP::GeomId::Captain::Photosensor(i),
+                                      clones);
                 if (!shape) break;
                 shape->SetMainColor(kYellow);
                 simple->AddElement(shape);
             }
-
-            gEve->AddGlobalElement(simple);
         }
+
+        /// The simplified geometries that have already been built.
+        CP::TGeometryCache fCache;
+
+        /// The element in the global scene holding the simplified geometry.
+        TEveGeoShape* fSimple;
     };
 };
 
+/// Build the dirty update handlers in the CP::TTaskPool, and commit each
+/// handler as soon as it has been built, so the event appears a piece at a
+/// time without blocking the GUI.  The event can't change while the
+/// handlers look at it since the manager cancels the jobs before it replaces
+/// the current event, and the job holds the event in the CP::TEventPrefetch
+/// (see TEventPrefetch::HoldEvent()) so that replacing it is caught.  The
+/// event lock isn't held by the job so that the prefetch thread can keep
+/// reading while the handlers are built.
+class CP::TEventChangeManager::UpdateJob: public CP::TVJob {
+public:
+    /// Start building the handlers.  This is called while holding the event
+    /// lock, and the job takes over the hold on the event that was taken by
+    /// UpdateEvent() before the lock.
+    UpdateJob(CP::TEventChangeManager& manager, CP::TEvent* event,
+              const Handlers& dirty)
+        : fManager(manager), fDirty(dirty),
+          fStart(CP::TTimingTable::GetTime()), fBuilt(false),
+          fPrefetch(manager.fPrefetch) {
+        // Copy the GUI settings for the handlers that are split into phases,
+        // and build them as parallel tasks.  The task timing is only kept
+        // for this update.
+        CP::TTaskPool& pool = CP::TEventDisplay::Get().Tasks();
+        pool.ResetTiming();
+        for (Handlers::iterator h = fDirty.begin(); h != fDirty.end(); ++h) {
+            if (!(*h)->IsTwoPhase()) continue;
+            CP::TScopedTimer timer((*h)->GetName(), "::Prepare");
+            (*h)->Prepare();
+            pool.Submit(new TBuildTask(*h, event, fResults, fCommitted),
+                        fGroup);
+        }
+    }
+
+    /// The job is deleted after it's finished or cancelled, so the builds
+    /// are no longer using the event.  Every handler drawn from an event
+    /// that was replaced by TEventPrefetch::LoadEventPaths() was dirty (the
+    /// event pointer is one of the inputs), and has been redrawn or
+    /// cleared, so the replaced events can be deleted.
+    ~UpdateJob() {
+        if (!fPrefetch) return;
+        fPrefetch->ReleaseEvent();
+        fPrefetch->DeleteReplacedEvents();
+    }
+
+    bool Step(double seconds) {
+        double start = CP::TTimingTable::GetTime();
+        CP::TTaskPool& pool = CP::TEventDisplay::Get().Tasks();
+
+        // When the pool doesn't have threads of its own, the builds only run
+        // here.
+        if (pool.GetThreadCount() < 2) {
+            while (CP::TTimingTable::GetTime() - start < seconds
+                   && pool.RunOne()) {}
+        }
+
+        // The result is posted before the build is counted as finished, so
+        // the queue has to be checked after the pool.
+        bool done = pool.IsDone(fGroup);
+        std::size_t committed = fCommitted.size();
+        fResults.Run(std::max(0.0,
+                              seconds - (CP::TTimingTable::GetTime()-start)));
+        if (!done || !fResults.IsEmpty()) {
+            // Show the handlers that have been committed so far.
+            if (fCommitted.size() != committed) {
+                gEve->GetEventScene()->Changed();
+                gEve->Redraw3D(kFALSE, kFALSE);
+            }
+            return false;
+        }
+
+        if (!fBuilt) {
+            fBuilt = true;
+            CP::TTimingTable* table = CP::TTimingTable::GetActive();
+            if (table) {
+                table->Add("Build", CP::TTimingTable::GetTime() - fStart);
+                pool.PrintTiming();
+            }
+        }
+
+        // Run through the handlers that aren't split into phases.
+        for (Handlers::iterator h = fDirty.begin(); h != fDirty.end(); ++h) {
+            if ((*h)->IsTwoPhase()) continue;
+            CP::TScopedTimer timer((*h)->GetName(), "::Apply");
+            (*h)->Apply();
+        }
 
-CP::TEventChangeManager::TEventChangeManager() {
+        // Drop the pooled elements that this event didn't need.
+        CP::TEventDisplay::Get().Pool().Trim();
+
+        // Make sure EVE is up to date.  Only the event scene is marked as
+        // changed (and only if a handler redrew its elements), so the GL
+        // viewer keeps the display lists for the geometry in the global
+        // scene and for the event elements when nothing changed.  The camera
+        // isn't reset unless it was asked for.
+        if (!fDirty.empty()) gEve->GetEventScene()->Changed();
+        {
+            CP::TScopedTimer timer("Redraw3D");
+            gEve->Redraw3D(fManager.fResetCamera, kFALSE);
+            fManager.fResetCamera = false;
+        }
+
+        // The time to draw the event sets the level of detail for the next
+        // event.  An update that didn't redraw anything isn't counted.
+        if (!fDirty.empty()) {
+            CP::TEventDisplay::Get().Budget().AddCost(
+                "Event", CP::TTimingTable::GetTime() - fStart);
+        }
+
+        fManager.ShowTiming();
+        return true;
+    }
+
+    void Cancel() {
+        CP::TTaskPool& pool = CP::TEventDisplay::Get().Tasks();
+        pool.Cancel(fGroup);
+        pool.Wait(fGroup);
+        fResults.Clear();
+
+        // Forget the inputs of the handlers that weren't finished, so they
+        // are run by the next update.  Their elements are from the last
+        // event, so they are cleared by committing an empty result.
+        for (Handlers::iterator h = fDirty.begin(); h != fDirty.end(); ++h) {
+            if (std::find(fCommitted.begin(), fCommitted.end(), *h)
+                != fCommitted.end()) continue;
+            fManager.fHandlerInputs.erase(*h);
+            if (!(*h)->IsTwoPhase()) continue;
+            (*h)->Prepare();
+            (*h)->Commit();
+        }
+        CaptLog("Cancelled update after " << fCommitted.size()
+                << " of " << fDirty.size() << " handlers");
+        if (!fDirty.empty()) {
+            gEve->GetEventScene()->Changed();
+            gEve->Redraw3D(kFALSE, kFALSE);
+        }
+    }
+
+    std::string GetName() const {return "Event";}
+
+    double GetProgress() const {
+        if (fDirty.empty()) return 1.0;
+        return double(fCommitted.size())/fDirty.size();
+    }
+
+private:
+    CP::TEventChangeManager& fManager;
+
+    /// The handlers that need to be run.
+    Handlers fDirty;
+
+    /// The handlers that have been committed.  This is only changed on the
+    /// main thread.
+    Handlers fCommitted;
+
+    /// The group of build tasks.
+    CP::TTaskPool::Group fGroup;
+
+    /// The commits posted by the build tasks.
+    CP::TResultQueue fResults;
+
+    /// The time that the job started.
+    double fStart;
+
+    /// A flag that all of the handlers have been built.
+    bool fBuilt;
+
+    /// The prefetcher holding the event that is being built (or NULL).
+    CP::TEventPrefetch* fPrefetch;
+};
+
+CP::TEventChangeManager::TEventChangeManager()
+    : fEventSource(NULL), fPrefetch(NULL), fCurrentEntry(0),
+      fEventIndex(NULL), fPendingRun(-1), fPendingEvent(-1),
+      fPendingEntry(-1), fPendingTimer(NULL),
+      fSkim(NULL), fSkimTimer(NULL), fFollowTimer(NULL), fFollowMatch(-1),
+      fQueuedChange(0), fQueuedCount(0), fQueueTimer(NULL),
+      fEventSerial(0),
+      fAutoplayTimer(NULL), fAutoplayStart(0), fAutoplayDeadline(0),
+      fAutoplayFrames(0), fAutoplayDropped(0),
+      fShowGeometry(false), fResetCamera(true), fJobTimer(NULL),
+      fJobBudget(0.03) {
     TGButton* button = CP::TEventDisplay::Get().GUI().GetNextEventButton();
     if (button) {
         button->Connect("Clicked()",
                         "CP::TEventChangeManager", 
                         this,
-                        "ChangeEvent(=1)");
+                        "QueueChangeEvent(=1)");
     }
 
     button = CP::TEventDisplay::Get().GUI().GetDrawEventButton();
@@ -111,23 +426,252 @@ CP::TEventChangeManager::TEventChangeManager() {
         button->Connect("Clicked()",
                         "CP::TEventChangeManager", 
                         this,
-                        "ChangeEvent(=-1)");
+                        "QueueChangeEvent(=-1)");
     }
 
+    button = CP::TEventDisplay::Get().GUI().GetJumpBack100Button();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "QueueChangeEvent(=-100)");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetJumpBack10Button();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "QueueChangeEvent(=-10)");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetJumpForward10Button();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "QueueChangeEvent(=10)");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetJumpForward100Button();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "QueueChangeEvent(=100)");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetGotoEntryButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "GotoSelectedEntry()");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetGotoEventButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "GotoSelectedEvent()");
+    }
+
+    TGTextEntry* eventName = CP::TEventDisplay::Get().GUI().GetEventName();
+    if (eventName) {
+        eventName->Connect("ReturnPressed()",
+                           "CP::TEventChangeManager", 
+                           this,
+                           "GotoSelectedEvent()");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetStartSkimButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "StartSelectedSkim()");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetStopSkimButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "StopSkim()");
+    }
+
+    TGTextEntry* skimSelection
+        = CP::TEventDisplay::Get().GUI().GetSkimSelection();
+    if (skimSelection) {
+        skimSelection->Connect("ReturnPressed()",
+                               "CP::TEventChangeManager", 
+                               this,
+                               "StartSelectedSkim()");
+    }
+
+    fSkimTimer = new TTimer(1000);
+    fSkimTimer->Connect("Timeout()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "ShowSkimStatus()");
+
+    fPendingTimer = new TTimer(250);
+    fPendingTimer->Connect("Timeout()",
+                           "CP::TEventChangeManager", 
+                           this,
+                           "CheckPendingEvent()");
+
+    button = CP::TEventDisplay::Get().GUI().GetFollowButton();
+    if (button) {
+        button->Connect("Toggled(Bool_t)",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "SetFollow(Bool_t)");
+    }
+
+    fFollowTimer = new TTimer(CP::TRuntimeParameters::Get().GetParameterI(
+                                  "eventDisplay.follow.period"));
+    fFollowTimer->Connect("Timeout()",
+                          "CP::TEventChangeManager", 
+                          this,
+                          "FollowEventSource()");
+
+    fQueueTimer = new TTimer(CP::TRuntimeParameters::Get().GetParameterI(
+                                 "eventDisplay.navigation.delay"));
+    fQueueTimer->Connect("Timeout()",
+                         "CP::TEventChangeManager", 
+                         this,
+                         "ApplyQueuedChange()");
+
+    button = CP::TEventDisplay::Get().GUI().GetAutoplayButton();
+    if (button) {
+        button->Connect("Toggled(Bool_t)",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "SetAutoplay(Bool_t)");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetTimingButton();
+    if (button) {
+        button->Connect("Toggled(Bool_t)",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "SetTiming(Bool_t)");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetSaveTimingButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "SaveTiming()");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetResetCameraButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "ResetCamera()");
+    }
+
+    button = CP::TEventDisplay::Get().GUI().GetStopJobsButton();
+    if (button) {
+        button->Connect("Clicked()",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "CancelJobs()");
+    }
+
+    fJobTimer = new TTimer(CP::TRuntimeParameters::Get().GetParameterI(
+                               "eventDisplay.jobs.period"));
+    fJobTimer->Connect("Timeout()",
+                       "CP::TEventChangeManager", 
+                       this,
+                       "RunJobs()");
+    fJobBudget = 0.001*CP::TRuntimeParameters::Get().GetParameterD(
+        "eventDisplay.jobs.budget");
+
+    button = CP::TEventDisplay::Get().GUI().GetFullDetailButton();
+    if (button) {
+        button->Connect("Toggled(Bool_t)",
+                        "CP::TEventChangeManager", 
+                        this,
+                        "SetFullDetail(Bool_t)");
+    }
+
+    TGNumberEntry* detailTarget
+        = CP::TEventDisplay::Get().GUI().GetDetailTarget();
+    if (detailTarget) {
+        detailTarget->Connect("ValueSet(Long_t)",
+                              "CP::TEventChangeManager", 
+                              this,
+                              "SetDetailTarget()");
+        detailTarget->GetNumberEntry()->Connect("ReturnPressed()",
+                                                "CP::TEventChangeManager", 
+                                                this,
+                                                "SetDetailTarget()");
+    }
+
+    fAutoplayTimer = new TTimer();
+    fAutoplayTimer->Connect("Timeout()",
+                            "CP::TEventChangeManager", 
+                            this,
+                            "AutoplayStep()");
+
     // Register a geometry change manager to handle when a new geometry
     // becomes available
     CP::TManager::Get().RegisterGeometryCallback(new GeometryChangeCallback);
 }
 
-CP::TEventChangeManager::~TEventChangeManager() {}
+CP::TEventChangeManager::~TEventChangeManager() {
+    CancelJobs();
+    if (fJobTimer) delete fJobTimer;
+    if (fAutoplayTimer) delete fAutoplayTimer;
+    if (fQueueTimer) delete fQueueTimer;
+    if (fFollowTimer) delete fFollowTimer;
+    if (fSkimTimer) delete fSkimTimer;
+    if (fPendingTimer) delete fPendingTimer;
+    if (fSkim) delete fSkim;
+    if (fEventIndex) delete fEventIndex;
+    if (fPrefetch) delete fPrefetch;
+}
 
-void CP::TEventChangeManager::SetEventSource(CP::TVInputFile* source) {
+void CP::TEventChangeManager::SetEventSource(CP::TVInputFile* source,
+                                             int firstEntry) {
     if (!source) {
         CaptError("Invalid event source");
         return;
     }
+    CancelJobs();
+    StopSkim();
+    if (fPrefetch) delete fPrefetch;
+    fPrefetch = NULL;
     fEventSource = source;
-    fEventSource->FirstEvent();
+    fCurrentEntry = 0;
+    if (CP::TEventPrefetch::IsRandomAccess(fEventSource)) {
+        int nextCount = CP::TRuntimeParameters::Get().GetParameterI(
+            "eventDisplay.prefetch.next");
+        int previousCount = CP::TRuntimeParameters::Get().GetParameterI(
+            "eventDisplay.prefetch.previous");
+        fPrefetch = new CP::TEventPrefetch(fEventSource,
+                                           nextCount, previousCount);
+        SetEventPaths();
+        if (firstEntry > 0 && firstEntry < fPrefetch->GetEntryCount()) {
+            fCurrentEntry = firstEntry;
+        }
+        CP::TEventDisplay::Get().Timing().StartEvent(fCurrentEntry);
+        CP::TScopedTimer timer("ReadEvent");
+        fPrefetch->GetEvent(fCurrentEntry);
+    }
+    else {
+        CP::TEventDisplay::Get().Timing().StartEvent(fCurrentEntry);
+        CP::TScopedTimer timer("ReadEvent");
+        TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
+        fEventSource->FirstEvent();
+    }
+    ShowEntryNumber();
     NewEvent();
     UpdateEvent();
 }
@@ -149,33 +693,426 @@ void CP::TEventChangeManager::ChangeEvent(int change) {
         UpdateEvent();
         return;
     }
+    if (fSkim && change != 0) {
+        int entry = fSkim->FindMatch(fCurrentEntry, change);
+        if (entry < 0) {
+            if (fSkim->IsComplete()) {
+                CaptError("No more events pass " << fSkim->GetDescription());
+            }
+            else {
+                CaptError("No more events pass " << fSkim->GetDescription()
+                          << " yet");
+            }
+            ShowSkimStatus();
+            return;
+        }
+        GotoEntry(entry);
+        return;
+    }
+    if (fPrefetch) {
+        GotoEntry(fCurrentEntry + change);
+        return;
+    }
+
+    if (change != 0) {
+        CancelJobs();
+        CP::TEventDisplay::Get().Timing().StartEvent(fCurrentEntry + change);
+    }
+    TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
     CP::TEvent* currentEvent = CP::TEventFolder::GetCurrentEvent();
     CP::TEvent* nextEvent = NULL;
-    if (change > 0) {
-        nextEvent = GetEventSource()->NextEvent(change-1);
-        if (!nextEvent) {
-            nextEvent = GetEventSource()->PreviousEvent();
+    {
+        CP::TScopedTimer timer("ReadEvent");
+        if (change > 0) {
+            nextEvent = GetEventSource()->NextEvent(change-1);
+            if (!nextEvent) {
+                nextEvent = GetEventSource()->PreviousEvent();
+            }
+            if (nextEvent && currentEvent) delete currentEvent;
+        }
+        if (change < 0) {
+            nextEvent = GetEventSource()->PreviousEvent(change+1);
+            if (!nextEvent) nextEvent = GetEventSource()->NextEvent();
+            if (nextEvent && currentEvent) delete currentEvent;
         }
-        if (nextEvent && currentEvent) delete currentEvent;
-    }
-    if (change < 0) {
-        nextEvent = GetEventSource()->PreviousEvent(change+1);
-        if (!nextEvent) nextEvent = GetEventSource()->NextEvent();
-        if (nextEvent && currentEvent) delete currentEvent;
     }
     currentEvent = CP::TEventFolder::GetCurrentEvent();
     if (!currentEvent) {
         CaptLog("No Current Event");
         return;
     }
+    fCurrentEntry = GetEventSource()->GetPosition();
+    ShowEntryNumber();
 
     if (change != 0) NewEvent(); 
 
     UpdateEvent();
 }
 
+void CP::TEventChangeManager::QueueChangeEvent(int change) {
+    if (!fQueueTimer) {
+        ChangeEvent(change);
+        return;
+    }
+    fQueuedChange += change;
+    ++fQueuedCount;
+
+    // Show where the display is going so that the user can see the clicks
+    // being counted (this isn't known while skimming).
+    TGNumberEntry* entryNumber
+        = CP::TEventDisplay::Get().GUI().GetEntryNumber();
+    if (entryNumber && fPrefetch && !fSkim) {
+        int target = fCurrentEntry + fQueuedChange;
+        target = std::max(0, std::min(target, fPrefetch->GetEntryCount()-1));
+        entryNumber->SetIntNumber(target);
+    }
+
+    // The timer only fires once the event loop has handled the pending GUI
+    // events, so all of the clicks made while an event was being drawn are
+    // merged.
+    fQueueTimer->Start(-1, kTRUE);
+}
+
+void CP::TEventChangeManager::ApplyQueuedChange() {
+    int change = fQueuedChange;
+    int count = fQueuedCount;
+    fQueuedChange = 0;
+    fQueuedCount = 0;
+    if (count < 1) return;
+    if (count > 1) {
+        CaptLog("Merged " << count << " event changes into " << change);
+    }
+    // Opposite clicks may cancel, and then there's nothing to draw.
+    if (change == 0) {
+        ShowEntryNumber();
+        return;
+    }
+    ChangeEvent(change);
+}
+
+void CP::TEventChangeManager::GotoEntry(int entry) {
+    if (!GetEventSource()) {
+        CaptError("Event source is not available");
+        return;
+    }
+
+    // Sequential sources can only move relative to the current event.
+    if (!fPrefetch) {
+        ChangeEvent(entry - fCurrentEntry);
+        return;
+    }
+
+    int target = std::max(0, std::min(entry, fPrefetch->GetEntryCount()-1));
+    if (target != entry) CaptLog("Stop at entry " << target);
+    CaptError("Go to entry " << target);
+
+    // The prefetcher seeks directly to the entry, so the cost doesn't depend
+    // on how far the jump is.  When the entry doesn't change (e.g. a
+    // redraw), the event that is already shown is used, since it may be held
+    // by the update that is still drawing it.
+    int previousEntry = fCurrentEntry;
+    if (target != fCurrentEntry || !CP::TEventFolder::GetCurrentEvent()) {
+        // The drawing of the old event is stopped before it's replaced.
+        CancelJobs();
+        if (target != fCurrentEntry) {
+            CP::TEventDisplay::Get().Timing().StartEvent(target);
+        }
+        CP::TScopedTimer timer("ReadEvent");
+        if (fPrefetch->GetEvent(target)) fCurrentEntry = target;
+        else fPrefetch->GetEvent(fCurrentEntry);
+    }
+    ShowEntryNumber();
+
+    if (!CP::TEventFolder::GetCurrentEvent()) {
+        CaptLog("No Current Event");
+        return;
+    }
+
+    if (fCurrentEntry != previousEntry) NewEvent();
+
+    UpdateEvent();
+}
+
+void CP::TEventChangeManager::SetEventIndex(CP::TEventIndex* index) {
+    if (fEventIndex) delete fEventIndex;
+    fEventIndex = index;
+}
+
+bool CP::TEventChangeManager::GotoEvent(int run, int event) {
+    if (!fEventIndex) {
+        CaptError("No event index available");
+        return false;
+    }
+    if (fPendingTimer) fPendingTimer->Stop();
+    int entry = fEventIndex->GetEntry(run, event);
+    if (entry < 0) {
+        if (fEventIndex->IsComplete()) {
+            CaptError("Event " << run << "." << event << " is not in file");
+            return false;
+        }
+        // Wait for the index instead of blocking the GUI.
+        CaptLog("Event " << run << "." << event
+                << " will be shown when it's indexed");
+        fPendingRun = run;
+        fPendingEvent = event;
+        fPendingEntry = fCurrentEntry;
+        if (fPendingTimer) fPendingTimer->Start(-1, kFALSE);
+        return false;
+    }
+    GotoEntry(entry);
+    return true;
+}
+
+void CP::TEventChangeManager::CheckPendingEvent() {
+    // Don't jump away from an event the user has moved to.
+    if (!fEventIndex || fCurrentEntry != fPendingEntry) {
+        if (fPendingTimer) fPendingTimer->Stop();
+        return;
+    }
+    int entry = fEventIndex->GetEntry(fPendingRun, fPendingEvent);
+    if (entry >= 0) {
+        if (fPendingTimer) fPendingTimer->Stop();
+        GotoEntry(entry);
+        return;
+    }
+    if (!fEventIndex->IsComplete()) return;
+    if (fPendingTimer) fPendingTimer->Stop();
+    CaptError("Event " << fPendingRun << "." << fPendingEvent
+              << " is not in file");
+}
+
+void CP::TEventChangeManager::GotoSelectedEvent() {
+    TGTextEntry* eventName = CP::TEventDisplay::Get().GUI().GetEventName();
+    if (!eventName) return;
+    int run;
+    int event;
+    if (!CP::TEventIndex::ParseEventName(eventName->GetText(), run, event)) {
+        CaptError("Event must be given as run.event, not \""
+                  << eventName->GetText() << "\"");
+        return;
+    }
+    GotoEvent(run, event);
+}
+
+void CP::TEventChangeManager::GotoSelectedEntry() {
+    TGNumberEntry* entryNumber
+        = CP::TEventDisplay::Get().GUI().GetEntryNumber();
+    if (!entryNumber) return;
+    GotoEntry(entryNumber->GetIntNumber());
+}
+
+bool CP::TEventChangeManager::StartSkim(const char* selection) {
+    if (!fPrefetch) {
+        CaptError("Skims need a random access event source");
+        return false;
+    }
+    CP::TVSkimPredicate* predicate
+        = CP::TEventSkim::MakePredicate(selection);
+    if (!predicate) {
+        CaptError("Invalid skim selection \"" << selection << "\"");
+        return false;
+    }
+    if (fSkim) delete fSkim;
+    int threads = CP::TRuntimeParameters::Get().GetParameterI(
+        "eventDisplay.skim.threads");
+    fSkim = new CP::TEventSkim(fEventSource, predicate, threads);
+    if (fSkimTimer) fSkimTimer->Start(1000, kFALSE);
+    ShowSkimStatus();
+    return true;
+}
+
+void CP::TEventChangeManager::StartSelectedSkim() {
+    TGTextEntry* skimSelection
+        = CP::TEventDisplay::Get().GUI().GetSkimSelection();
+    if (!skimSelection) return;
+    StartSkim(skimSelection->GetText());
+}
+
+void CP::TEventChangeManager::StopSkim() {
+    if (fSkimTimer) fSkimTimer->Stop();
+    if (fSkim) delete fSkim;
+    fSkim = NULL;
+    ShowSkimStatus();
+}
+
+void CP::TEventChangeManager::ShowSkimStatus() {
+    TGLabel* skimStatus = CP::TEventDisplay::Get().GUI().GetSkimStatus();
+    if (!fSkim) {
+        if (skimStatus) skimStatus->SetText("Showing all events");
+        return;
+    }
+    std::ostringstream status;
+    status << fSkim->GetDescription() << ": "
+           << fSkim->GetMatchCount() << " pass, "
+           << fSkim->GetScannedCount() << "/" << fSkim->GetEntryCount()
+           << " read";
+    if (fSkim->IsComplete() && fSkimTimer) fSkimTimer->Stop();
+    if (skimStatus) skimStatus->SetText(status.str().c_str());
+}
+
+void CP::TEventChangeManager::SetFollow(bool follow) {
+    TGButton* button = CP::TEventDisplay::Get().GUI().GetFollowButton();
+    if (button) button->SetOn(follow);
+    if (!fFollowTimer) return;
+    if (!follow) {
+        fFollowTimer->Stop();
+        return;
+    }
+    if (!fPrefetch) {
+        CaptError("Following needs a random access input file");
+        if (button) button->SetOn(kFALSE);
+        return;
+    }
+    CaptLog("Follow " << fEventSource->GetInputName());
+    fFollowTimer->Start(-1, kFALSE);
+    fFollowMatch = -1;
+    int entries = fPrefetch->Refresh();
+    if (fSkim) {
+        FollowSkim(entries);
+        return;
+    }
+    GotoEntry(entries-1);
+}
+
+bool CP::TEventChangeManager::GetFollow() const {
+    TGButton* button = CP::TEventDisplay::Get().GUI().GetFollowButton();
+    if (!button) return false;
+    return button->IsOn();
+}
+
+void CP::TEventChangeManager::FollowEventSource() {
+    if (!fPrefetch) return;
+    // Only move when the writer has added entries so that the older events
+    // can still be looked at between updates.
+    int previous = fPrefetch->GetEntryCount();
+    int entries = fPrefetch->Refresh();
+    if (fSkim) {
+        FollowSkim(entries);
+        return;
+    }
+    if (entries <= previous) return;
+    GotoEntry(entries-1);
+}
+
+void CP::TEventChangeManager::FollowSkim(int entries) {
+    if (entries > fSkim->GetEntryCount()) {
+        fSkim->AddEntries(entries);
+        if (fSkimTimer) fSkimTimer->Start(1000, kFALSE);
+        ShowSkimStatus();
+    }
+    // The matches are found by the skim threads, so this is checked every
+    // time the timer fires, and not just when there are new entries.
+    int match = fSkim->FindMatch(entries, -1);
+    if (match <= fFollowMatch) return;
+    fFollowMatch = match;
+    GotoEntry(match);
+}
+
+void CP::TEventChangeManager::SetAutoplay(bool play) {
+    TGButton* button = CP::TEventDisplay::Get().GUI().GetAutoplayButton();
+    if (button) button->SetOn(play);
+    if (!fAutoplayTimer) return;
+    if (!play) {
+        fAutoplayTimer->Stop();
+        ShowAutoplayStatus();
+        return;
+    }
+    fAutoplayStart = gSystem->Now();
+    fAutoplayDeadline = fAutoplayStart;
+    fAutoplayFrames = 0;
+    fAutoplayDropped = 0;
+    fAutoplayTimer->Start(0, kTRUE);
+    ShowAutoplayStatus();
+}
+
+bool CP::TEventChangeManager::GetAutoplay() const {
+    TGButton* button = CP::TEventDisplay::Get().GUI().GetAutoplayButton();
+    if (!button) return false;
+    return button->IsOn();
+}
+
+void CP::TEventChangeManager::AutoplayStep() {
+    if (!GetAutoplay()) return;
+
+    // Let the last frame finish drawing.  Moving now would cancel it, and a
+    // large event would never be shown.  The frames that are missed while
+    // waiting are dropped below.
+    if (HasJob("Event")) {
+        fAutoplayTimer->Start(CP::TRuntimeParameters::Get().GetParameterI(
+                                  "eventDisplay.jobs.period"), kTRUE);
+        return;
+    }
+
+    double rate = 0.0;
+    TGNumberEntry* rateEntry
+        = CP::TEventDisplay::Get().GUI().GetAutoplayRate();
+    if (rateEntry) rate = rateEntry->GetNumber();
+    if (rate <= 0.0) {
+        rate = CP::TRuntimeParameters::Get().GetParameterD(
+            "eventDisplay.autoplay.rate");
+    }
+    Long64_t period = std::max(Long64_t(1), Long64_t(1000.0/rate));
+
+    // Skip the frames whose deadlines passed while the last frame was being
+    // drawn so that the display keeps up with the rate.
+    Long64_t now = gSystem->Now();
+    int step = 1;
+    if (now > fAutoplayDeadline + period) {
+        int missed = (now - fAutoplayDeadline)/period;
+        step += missed;
+        fAutoplayDropped += missed;
+        fAutoplayDeadline += missed*period;
+    }
+    fAutoplayDeadline += period;
+
+    int previousEntry = fCurrentEntry;
+    ChangeEvent(step);
+    if (fCurrentEntry != previousEntry) {
+        ++fAutoplayFrames;
+    }
+    else if (!GetFollow()) {
+        CaptLog("Autoplay reached the last event");
+        SetAutoplay(false);
+        return;
+    }
+    ShowAutoplayStatus();
+
+    now = gSystem->Now();
+    fAutoplayTimer->Start(std::max(Long64_t(0), fAutoplayDeadline - now),
+                          kTRUE);
+}
+
+void CP::TEventChangeManager::ShowAutoplayStatus() {
+    TGLabel* status = CP::TEventDisplay::Get().GUI().GetAutoplayStatus();
+    if (!status) return;
+    std::ostringstream text;
+    if (!GetAutoplay()) text << "Autoplay stopped";
+    else text << "Autoplay";
+    Long64_t elapsed = Long64_t(gSystem->Now()) - fAutoplayStart;
+    if (fAutoplayFrames > 0 && elapsed > 0) {
+        text << std::fixed << std::setprecision(1)
+             << ": " << 1000.0*fAutoplayFrames/elapsed << " Hz, "
+             << fAutoplayDropped << " dropped";
+    }
+    status->SetText(text.str().c_str());
+}
+
+int CP::TEventChangeManager::GetEntryCount() {
+    if (fPrefetch) return fPrefetch->GetEntryCount();
+    return -1;
+}
+
+void CP::TEventChangeManager::ShowEntryNumber() {
+    TGNumberEntry* entryNumber
+        = CP::TEventDisplay::Get().GUI().GetEntryNumber();
+    if (!entryNumber) return;
+    entryNumber->SetIntNumber(fCurrentEntry);
+}
+
 void CP::TEventChangeManager::NewEvent() {
     CaptError("New Event");
+    CP::TScopedTimer timer("NewEvent");
+    TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
 
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
     if (!event) {
@@ -184,6 +1121,12 @@ void CP::TEventChangeManager::NewEvent() {
     }
 
     CaptLog("Event: " << event->GetContext());
+    ++fEventSerial;
+
+    // Forget the summary and handles of the last event.  The summary for
+    // this event is filled when a plot first needs it.
+    CP::TEventDisplay::Get().Summary().Reset();
+    CP::TEventDisplay::Get().Handles().Reset();
 
     // Let the database handlers know about the new event context.
     CP::TChannelInfo::Get().SetContext(event->GetContext());
@@ -191,15 +1134,82 @@ void CP::TEventChangeManager::NewEvent() {
     // Run through all of the handlers.
     for (Handlers::iterator h = fNewEventHandlers.begin();
          h != fNewEventHandlers.end(); ++h) {
+        CP::TScopedTimer timer((*h)->GetName(), "::Apply");
         (*h)->Apply();
     }
 
 }
 
+void CP::TEventChangeManager::SetEventPaths() {
+    if (!fPrefetch) return;
+    std::vector<std::string> paths;
+    for (Handlers::iterator h = fNewEventHandlers.begin();
+         h != fNewEventHandlers.end(); ++h) {
+        (*h)->AddEventPaths(paths);
+    }
+    for (Handlers::iterator h = fUpdateHandlers.begin();
+         h != fUpdateHandlers.end(); ++h) {
+        (*h)->AddEventPaths(paths);
+    }
+    // The jobs looking at the current event are stopped if it's going to be
+    // read again.
+    if (!fPrefetch->IsLoaded(paths)) CancelJobs();
+    fPrefetch->SetEventPaths(paths);
+}
+
+bool CP::TEventChangeManager::LoadEventPaths(
+    const std::vector<std::string>& paths,
+    const char* className, void* object, const char* method) {
+    // The plot waits behind the update (without blocking the GUI), and is
+    // drawn when the update is finished.  Asking twice only draws it once.
+    if (HasJob("Event")) {
+        for (std::vector<PendingPlot>::iterator p = fPendingPlots.begin();
+             p != fPendingPlots.end(); ++p) {
+            if (p->object == object && p->method == method) return false;
+        }
+        PendingPlot plot;
+        plot.className = className;
+        plot.object = object;
+        plot.method = method;
+        fPendingPlots.push_back(plot);
+        CaptLog("Draw " << className << "::" << method
+                << " after the event is drawn");
+        return false;
+    }
+    if (!fPrefetch) return true;
+    if (!fPrefetch->IsLoaded(paths)) CancelJobs();
+    fPrefetch->LoadEventPaths(paths);
+    return true;
+}
+
+void CP::TEventChangeManager::DrawPendingPlots() {
+    if (fPendingPlots.empty() || HasJob("Event")) return;
+    for (std::vector<PendingPlot>::iterator p = fPendingPlots.begin();
+         p != fPendingPlots.end(); ++p) {
+        TTimer::SingleShot(0, p->className.c_str(), p->object,
+                           p->method.c_str());
+    }
+    fPendingPlots.clear();
+}
+
 void CP::TEventChangeManager::UpdateEvent() {
+    // Stop an update that is still running.  This has to be done first since
+    // the handlers that weren't finished are marked to be run again.
+    CancelJob("Event");
+
+    // Make sure that the current event has the folders needed by the
+    // handlers (e.g. after a "Show" button has been turned on).  This has to
+    // be done before taking the event lock.
+    SetEventPaths();
+
+    // The event is held for the job (see UpdateJob) before taking the event
+    // lock, since the prefetcher takes its own lock to count the hold.
+    if (fPrefetch) fPrefetch->HoldEvent();
+    TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
 
     if (!event) {
+        if (fPrefetch) fPrefetch->ReleaseEvent();
         CaptError("Invalid event");
         return;
     }
@@ -207,12 +1217,167 @@ void CP::TEventChangeManager::UpdateEvent() {
     // Make sure that the event geometry is updated.
     CP::TManager::Get().Geometry();
     
-    // Run through all of the handlers.
+    // Find the handlers whose inputs have changed since they last ran.  The
+    // other handlers keep the Eve elements they already made.  The event
+    // pointer is part of the inputs since the event is replaced when more
+    // folders are read.
+    Handlers dirty;
     for (Handlers::iterator h = fUpdateHandlers.begin();
          h != fUpdateHandlers.end(); ++h) {
-        (*h)->Apply();
+        std::ostringstream inputs;
+        inputs << fEventSerial << " " << event << " ";
+        if (!(*h)->AddInputs(inputs)) {
+            dirty.push_back(*h);
+            continue;
+        }
+        std::string& last = fHandlerInputs[*h];
+        if (last == inputs.str()) continue;
+        last = inputs.str();
+        dirty.push_back(*h);
+    }
+    CaptLog("Update " << dirty.size() << " of " << fUpdateHandlers.size()
+            << " handlers");
+
+    // The handlers are built by the task pool, and committed by the job
+    // timer as they finish.
+    AddJob(new UpdateJob(*this, event, dirty));
+}
+
+void CP::TEventChangeManager::ResetCamera() {
+    // This only resets the camera, so no scenes are marked as changed.
+    gEve->Redraw3D(kTRUE, kFALSE);
+}
+
+void CP::TEventChangeManager::AddJob(CP::TVJob* job) {
+    if (!job) return;
+    CancelJob(job->GetName());
+    fJobs.push_back(job);
+    if (fJobTimer) fJobTimer->Start(-1, kFALSE);
+    ShowJobStatus();
+}
+
+void CP::TEventChangeManager::CancelJob(const std::string& name) {
+    for (std::vector<CP::TVJob*>::iterator j = fJobs.begin();
+         j != fJobs.end();) {
+        if ((*j)->GetName() != name) {
+            ++j;
+            continue;
+        }
+        CP::TVJob* job = *j;
+        j = fJobs.erase(j);
+        job->Cancel();
+        delete job;
     }
+    if (fJobs.empty() && fJobTimer) fJobTimer->Stop();
+    ShowJobStatus();
+    DrawPendingPlots();
+}
+
+void CP::TEventChangeManager::CancelJobs() {
+    // The list is emptied first so that a job can't be cancelled twice.
+    std::vector<CP::TVJob*> jobs;
+    jobs.swap(fJobs);
+    for (std::vector<CP::TVJob*>::iterator j = jobs.begin();
+         j != jobs.end(); ++j) {
+        (*j)->Cancel();
+        delete (*j);
+    }
+    if (fJobTimer) fJobTimer->Stop();
+    ShowJobStatus();
+    DrawPendingPlots();
+}
 
-    // Make sure EVE is up to date.
-    gEve->Redraw3D(kTRUE);
+bool CP::TEventChangeManager::HasJob(const std::string& name) const {
+    for (std::vector<CP::TVJob*>::const_iterator j = fJobs.begin();
+         j != fJobs.end(); ++j) {
+        if ((*j)->GetName() == name) return true;
+    }
+    return false;
+}
+
+void CP::TEventChangeManager::RunJobs() {
+    // Share the budget between the jobs so the timer returns to the event
+    // loop within about a frame.  A job may add or cancel jobs while it
+    // runs, so the list is copied.
+    std::vector<CP::TVJob*> jobs(fJobs);
+    double start = CP::TTimingTable::GetTime();
+    for (std::vector<CP::TVJob*>::iterator j = jobs.begin();
+         j != jobs.end(); ++j) {
+        if (std::find(fJobs.begin(), fJobs.end(), *j) == fJobs.end()) {
+            continue;
+        }
+        double left = fJobBudget - (CP::TTimingTable::GetTime() - start);
+        if (!(*j)->Step(std::max(0.001, left))) continue;
+        std::vector<CP::TVJob*>::iterator finished
+            = std::find(fJobs.begin(), fJobs.end(), *j);
+        if (finished == fJobs.end()) continue;
+        fJobs.erase(finished);
+        delete (*j);
+        ShowDetailStatus();
+    }
+    if (fJobs.empty() && fJobTimer) fJobTimer->Stop();
+    ShowJobStatus();
+    DrawPendingPlots();
+}
+
+void CP::TEventChangeManager::ShowJobStatus() {
+    TGLabel* status = CP::TEventDisplay::Get().GUI().GetJobStatus();
+    if (!status) return;
+    std::ostringstream text;
+    if (fJobs.empty()) text << "Idle";
+    else text << "Drawing";
+    for (std::vector<CP::TVJob*>::iterator j = fJobs.begin();
+         j != fJobs.end(); ++j) {
+        text << (j == fJobs.begin() ? ": " : ", ")
+             << (*j)->GetName() << " "
+             << int(100.0*(*j)->GetProgress()) << "%";
+    }
+    status->SetText(text.str().c_str());
+}
+
+void CP::TEventChangeManager::SetFullDetail(bool full) {
+    TGButton* button = CP::TEventDisplay::Get().GUI().GetFullDetailButton();
+    if (button) button->SetOn(full);
+    CP::TEventDisplay::Get().Budget().SetFullDetail(full);
+    ShowDetailStatus();
+}
+
+void CP::TEventChangeManager::SetDetailTarget() {
+    TGNumberEntry* detailTarget
+        = CP::TEventDisplay::Get().GUI().GetDetailTarget();
+    if (!detailTarget) return;
+    CP::TEventDisplay::Get().Budget().SetTarget(
+        0.001*detailTarget->GetNumber());
+    ShowDetailStatus();
+}
+
+void CP::TEventChangeManager::ShowDetailStatus() {
+    TGLabel* status = CP::TEventDisplay::Get().GUI().GetDetailStatus();
+    if (!status) return;
+    status->SetText(CP::TEventDisplay::Get().Budget().GetStatus().c_str());
+}
+
+void CP::TEventChangeManager::SetTiming(bool enabled) {
+    TGButton* button = CP::TEventDisplay::Get().GUI().GetTimingButton();
+    if (button) button->SetOn(enabled);
+    CP::TEventDisplay::Get().Timing().SetEnabled(enabled);
+    ShowTiming();
+}
+
+void CP::TEventChangeManager::SaveTiming() {
+    TGTextEntry* file = CP::TEventDisplay::Get().GUI().GetTimingFile();
+    if (!file) return;
+    CP::TEventDisplay::Get().Timing().WriteCSV(file->GetText());
+}
+
+void CP::TEventChangeManager::ShowTiming() {
+    TGListBox* list = CP::TEventDisplay::Get().GUI().GetTimingList();
+    if (!list) return;
+    std::vector<std::string> lines;
+    CP::TEventDisplay::Get().Timing().GetSummary(lines);
+    list->RemoveAll();
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        list->AddEntry(lines[i].c_str(), i);
+    }
+    list->Layout();
 }
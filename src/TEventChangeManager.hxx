@@ -4,9 +4,19 @@
 
 #include <TObject.h>
 
+#include <map>
+#include <string>
+#include <vector>
+
+class TTimer;
+
 namespace CP {
     class TEventChangeManager;
     class TVEventChangeHandler;
+    class TEventPrefetch;
+    class TEventIndex;
+    class TEventSkim;
+    class TVJob;
 
 };
 
@@ -19,17 +29,162 @@ public:
     virtual ~TEventChangeManager();
 
     /// Set or get the event source.  When the event source is set, the first
-    /// event is read.  @{
-    void SetEventSource(TVInputFile* source);
+    /// event is read (or the entry provided as firstEntry for random access
+    /// sources).  If the source supports random access, the neighboring
+    /// events are read ahead of time by a CP::TEventPrefetch object.  @{
+    void SetEventSource(TVInputFile* source, int firstEntry = 0);
     TVInputFile* GetEventSource() {return fEventSource;}
     /// @}
 
     /// Trigger an event change.  The argument says how many events to read.
     /// If it's positive, then it reads forward in the file.  If the change is
-    /// zero, then the current event is just redrawn.  This is connected to
-    /// the GUI buttons.
+    /// zero, then the current event is just redrawn.  When a skim is active,
+    /// the change counts the events passing the skim selection.  This is
+    /// connected to the GUI buttons.
     void ChangeEvent(int change=1);
 
+    /// Queue an event change.  The changes queued before the event loop is
+    /// idle (e.g. several clicks on "Next Event" while an event is being
+    /// drawn) are merged into a single call to ChangeEvent(), so only the
+    /// final event is read and drawn.  This is connected to the GUI
+    /// navigation buttons.
+    void QueueChangeEvent(int change);
+
+    /// Apply the queued event changes.  This is called by a timer.
+    void ApplyQueuedChange();
+
+    /// Go to an entry in the event source.  When the source supports random
+    /// access, this seeks straight to the entry, so a jump costs the same as
+    /// a single step.  Otherwise, the source is read sequentially.  Entries
+    /// past the ends of the source are clamped to the first or last entry.
+    void GotoEntry(int entry);
+
+    /// Go to the entry selected in the GUI entry number widget.  This is
+    /// connected to the GUI "Go to Entry" button.
+    void GotoSelectedEntry();
+
+    /// Set or get the index used to find events by run and event number.
+    /// The manager takes ownership of the index.  @{
+    void SetEventIndex(CP::TEventIndex* index);
+    CP::TEventIndex* GetEventIndex() {return fEventIndex;}
+    /// @}
+
+    /// Go to an event using the run and event number.  This uses the event
+    /// index, and returns false if the event can't be found.  If the event
+    /// hasn't been indexed yet, the display goes to it when the index finds
+    /// it (unless the user has moved to another event first).
+    bool GotoEvent(int run, int event);
+
+    /// Check if the event waiting to be indexed has been found, and go to
+    /// it.  This is called by a timer after GotoEvent() while the file is
+    /// being indexed.
+    void CheckPendingEvent();
+
+    /// Go to the "run.event" selected in the GUI event name widget.  This is
+    /// connected to the GUI "Go to Event" button.
+    void GotoSelectedEvent();
+
+    /// Start skimming the event source with a selection (see
+    /// CP::TEventSkim::MakePredicate()).  While the skim is active,
+    /// ChangeEvent() only moves through the events that pass the selection.
+    /// This returns false if the skim can't be started.
+    bool StartSkim(const char* selection);
+
+    /// Start a skim using the selection in the GUI.  This is connected to
+    /// the GUI "Skim" button.
+    void StartSelectedSkim();
+
+    /// Stop the skim so that all events are shown.  This is connected to the
+    /// GUI "All" button.
+    void StopSkim();
+
+    /// Show the progress of the skim in the GUI.  This is called by a timer
+    /// while the skim is running.
+    void ShowSkimStatus();
+
+    /// Get the active skim (or NULL).
+    CP::TEventSkim* GetSkim() {return fSkim;}
+
+    /// Start (or stop) following an input file that is still being written.
+    /// While following, the input file is checked for new entries every
+    /// "eventDisplay.follow.period" milliseconds, and the newest entry is
+    /// shown when new entries are found.  Only the entries committed by the
+    /// writer (with TTree::AutoSave()) are seen, so the event shown is
+    /// always complete.  When a skim is running, the new entries are added
+    /// to it, and the newest entry that passes the skim is shown.  This is
+    /// connected to the GUI "Follow Newest Event" button.
+    void SetFollow(bool follow);
+
+    /// Check if the display is following the input file.
+    bool GetFollow() const;
+
+    /// Check the input file for new entries, and go to the newest entry if
+    /// any were found (or the newest entry passing the skim if one is
+    /// running).  This is called by a timer while following the file.
+    void FollowEventSource();
+
+    /// Start (or stop) stepping through the events automatically.  The rate
+    /// is taken from the GUI (in Hz).  If drawing an event takes longer than
+    /// the time between frames, the frames that were missed are dropped
+    /// (i.e. the events are skipped) so that the display keeps up with the
+    /// rate.  Autoplay stops at the end of the events unless the file is
+    /// being followed.  This is connected to the GUI "Autoplay" button.
+    void SetAutoplay(bool play);
+
+    /// Check if autoplay is running.
+    bool GetAutoplay() const;
+
+    /// Show the next autoplay frame.  This is called by a timer.
+    void AutoplayStep();
+
+    /// Enable (or disable) collecting the time spent drawing each event.
+    /// This is connected to the GUI "Collect Timing" button.
+    void SetTiming(bool enabled);
+
+    /// Write the timing for the recent events to the CSV file named in the
+    /// GUI.  This is connected to the GUI "Save Timing CSV" button.
+    void SaveTiming();
+
+    /// Reset the camera to show the whole scene.  The camera is otherwise
+    /// only reset when the first event (or a new geometry) is drawn.  This
+    /// is connected to the GUI "Reset Camera" button.
+    void ResetCamera();
+
+    /// Add a job (taking ownership of the job) that is run in the
+    /// background by a GUI timer (see CP::TVJob).  A running job with the
+    /// same name is cancelled first.
+    void AddJob(CP::TVJob* job);
+
+    /// Cancel the running jobs with a name.
+    void CancelJob(const std::string& name);
+
+    /// Cancel all of the running jobs.  This is called before the current
+    /// event is replaced, and is connected to the GUI "Stop" button.
+    void CancelJobs();
+
+    /// Check if a job with a name is running.
+    bool HasJob(const std::string& name) const;
+
+    /// Run the next step of each job.  This is called by a timer while there
+    /// are jobs.
+    void RunJobs();
+
+    /// Force (or stop forcing) the event to be drawn with full detail (see
+    /// CP::TFrameBudget).  This is connected to the GUI "Full Detail"
+    /// button.
+    void SetFullDetail(bool full);
+
+    /// Set the time allowed to draw an event from the GUI.  This is
+    /// connected to the GUI budget widget.
+    void SetDetailTarget();
+
+    /// Get the entry number of the current event.
+    int GetCurrentEntry() const {return fCurrentEntry;}
+
+    /// Get the number of entries in the event source, or -1 if the source
+    /// doesn't know how many entries it contains.
+    int GetEntryCount();
+
     /// Add a handler (taking ownership of the handler) for when the event
     /// changes (e.g. a new event is read).  These handlers are for
     /// "once-per-event" actions and are executed by the NewEvent() method.
@@ -40,6 +195,22 @@ public:
     /// method.
     void AddUpdateHandler(CP::TVEventChangeHandler* handler);
     
+    /// Make sure that the current event contains the folders for the event
+    /// paths.  Folders that aren't needed by the event change handlers may
+    /// have been removed from the event to save memory, so this is used by
+    /// the plots before they look at the event.  The folders are read again
+    /// if needed, so the current event may be replaced.  The plots take
+    /// handles to the same objects as the handlers, and the handle counts
+    /// aren't thread safe, so the plot can't be drawn while the event is
+    /// being drawn.  In that case, this returns false, and the plot is drawn
+    /// again when the event is finished by calling the method of the object
+    /// (like TQObject::Connect(), e.g. "CP::TPlotDigitsHits", plot,
+    /// "DrawDigits(=0)").  The plot should return without drawing when this
+    /// returns false.
+    bool LoadEventPaths(const std::vector<std::string>& paths,
+                        const char* className, void* object,
+                        const char* method);
+
     /// Set the flag to show (or not show) the geometry
     void SetShowGeometry(bool f) {fShowGeometry = f;}
     bool GetShowGeometry() const {return fShowGeometry;}
@@ -55,9 +226,106 @@ private:
     /// handlers.
     void UpdateEvent();
 
+    /// Show the current entry number in the GUI.
+    void ShowEntryNumber();
+
+    /// Show the achieved autoplay rate and the dropped frames in the GUI.
+    void ShowAutoplayStatus();
+
+    /// Add the new entries to the skim, and go to the newest entry passing
+    /// the skim if it hasn't been shown yet.  The input has "entries"
+    /// entries.
+    void FollowSkim(int entries);
+
+    /// Show the timing summary in the GUI.
+    void ShowTiming();
+
+    /// Show the progress of the running jobs in the GUI.
+    void ShowJobStatus();
+
+    /// Draw the plots that were waiting for the event to be drawn (see
+    /// LoadEventPaths()).  The plots are drawn from the ROOT event loop,
+    /// and not while the jobs are being run.
+    void DrawPendingPlots();
+
+    /// Show the drawing times and the levels of detail in the GUI.
+    void ShowDetailStatus();
+
+    /// Collect the event paths needed by the event change handlers and pass
+    /// them to the prefetcher so that the other large folders don't need to
+    /// be kept in memory.
+    void SetEventPaths();
+
     /// The input source of events.
     TVInputFile* fEventSource;
 
+    /// The object reading events ahead of the display.  This is NULL if the
+    /// event source doesn't support random access.
+    CP::TEventPrefetch* fPrefetch;
+
+    /// The entry number of the current event.
+    int fCurrentEntry;
+
+    /// The index of the run and event numbers in the event source.
+    CP::TEventIndex* fEventIndex;
+
+    /// The run and event number waiting to be found by the event index, and
+    /// the entry that was shown when it was asked for.
+    int fPendingRun;
+    int fPendingEvent;
+    int fPendingEntry;
+
+    /// The timer used to check the event index for the pending event.
+    TTimer* fPendingTimer;
+
+    /// The skim selecting the events to show.  This is NULL when all events
+    /// are shown.
+    CP::TEventSkim* fSkim;
+
+    /// The timer used to show the progress of the skim.
+    TTimer* fSkimTimer;
+
+    /// The timer used to check for new entries while following the file.
+    TTimer* fFollowTimer;
+
+    /// The newest entry passing the skim that has been shown while
+    /// following the file.  The skim finds the matches in the new entries
+    /// after they are added, so the display only moves when a newer match is
+    /// found, and the older events can be looked at in between.
+    int fFollowMatch;
+
+    /// The sum of the event changes that have been queued.
+    int fQueuedChange;
+
+    /// The number of event changes that have been queued.
+    int fQueuedCount;
+
+    /// The timer used to apply the queued event changes.
+    TTimer* fQueueTimer;
+
+    /// A counter incremented for each new event.  This is part of the inputs
+    /// of every handler.
+    int fEventSerial;
+
+    /// The inputs of each update handler when it was last run (see
+    /// CP::TVEventChangeHandler::AddInputs()).
+    std::map<CP::TVEventChangeHandler*, std::string> fHandlerInputs;
+
+    /// The timer used to show the autoplay frames.
+    TTimer* fAutoplayTimer;
+
+    /// The time (in ms) that autoplay started.
+    Long64_t fAutoplayStart;
+
+    /// The time (in ms) that the next autoplay frame is due.
+    Long64_t fAutoplayDeadline;
+
+    /// The number of frames shown by autoplay.
+    int fAutoplayFrames;
+
+    /// The number of frames dropped by autoplay.
+    int fAutoplayDropped;
+
     typedef std::vector<CP::TVEventChangeHandler*> Handlers;
 
     /// The event update handlers.
@@ -69,6 +337,35 @@ private:
     /// Flag to determine if the geometry will be drawn.
     bool fShowGeometry;
 
+    /// Flag that the camera should be reset when the next event is drawn
+    /// (i.e. the first event).
+    bool fResetCamera;
+
+    /// The jobs running in the background.
+    std::vector<CP::TVJob*> fJobs;
+
+    /// The timer used to run the jobs.
+    TTimer* fJobTimer;
+
+    /// The time (in seconds) that the jobs can use each time the timer
+    /// fires.
+    double fJobBudget;
+
+    /// A plot waiting for the event to be drawn (see LoadEventPaths()).
+    struct PendingPlot {
+        std::string className;
+        void* object;
+        std::string method;
+    };
+
+    /// The plots waiting for the event to be drawn.
+    std::vector<PendingPlot> fPendingPlots;
+
+    /// The job that builds and commits the update handlers (see
+    /// UpdateEvent()).
+    class UpdateJob;
+    friend class UpdateJob;
+
     ClassDef(TEventChangeManager,0);
 };
 
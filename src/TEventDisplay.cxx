@@ -9,6 +9,13 @@
 #include "TG4HitChangeHandler.hxx"
 #include "TFitChangeHandler.hxx"
 #include "TPMTChangeHandler.hxx"
+#include "TTaskPool.hxx"
+#include "TTimingTable.hxx"
+#include "TEvePool.hxx"
+#include "TEventSummary.hxx"
+#include "THandleCache.hxx"
+#include "TFrameBudget.hxx"
+#include "TGeometryVoxels.hxx"
 
 #include <TCaptLog.hxx>
 #include <TRuntimeParameters.hxx>
@@ -30,7 +37,7 @@ CP::TEventDisplay& CP::TEventDisplay::Get(void) {
     return *fEventDisplay;
 }
 
-CP::TEventDisplay::TEventDisplay() {}
+CP::TEventDisplay::TEventDisplay() : fGeometrySerial(0) {}
 
 void CP::TEventDisplay::Init() {
     TEveManager::Create();
@@ -40,6 +47,41 @@ void CP::TEventDisplay::Init() {
     glViewer->SetGuideState(TGLUtil::kAxesEdge,kTRUE,kFALSE,0);
     glViewer->SetDrawCameraCenter(kTRUE);
 
+    // This is accessed through the Timing() method.
+    fTimingTable = new TTimingTable(
+        CP::TRuntimeParameters::Get().GetParameterI(
+            "eventDisplay.timing.history"));
+
+    // This is accessed through the Tasks() method.
+    fTaskPool = new TTaskPool(
+        CP::TRuntimeParameters::Get().GetParameterI(
+            "eventDisplay.tasks.threads"));
+
+    // This is accessed through the Pool() method.
+    fEvePool = new TEvePool(
+        CP::TRuntimeParameters::Get().GetParameterI(
+            "eventDisplay.pool.maximum"));
+
+    // This is accessed through the Summary() method.
+    fEventSummary = new TEventSummary();
+
+    // This is accessed through the Handles() method.
+    fHandleCache = new THandleCache();
+
+    // This is accessed through the Budget() method.
+    fFrameBudget = new TFrameBudget(
+        0.001*CP::TRuntimeParameters::Get().GetParameterD(
+            "eventDisplay.detail.target"),
+        CP::TRuntimeParameters::Get().GetParameterI(
+            "eventDisplay.detail.history"));
+
+    // This is accessed through the Voxels() method.
+    fGeometryVoxels = new TGeometryVoxels(
+        CP::TRuntimeParameters::Get().GetParameterD(
+            "eventDisplay.voxels.size"),
+        CP::TRuntimeParameters::Get().GetParameterD(
+            "eventDisplay.voxels.margin"));
+
     // This is accessed through the GUI() method.
     fGUIManager = new TGUIManager();
 
@@ -120,6 +162,11 @@ CP::TEventDisplay::~TEventDisplay() {
     CaptLog("Event display deconstructed");
 }
 
+void CP::TEventDisplay::GeometryChanged() {
+    ++fGeometrySerial;
+    fGeometryVoxels->Start();
+}
+
 int CP::TEventDisplay::LinearColor(double value, double minVal, double maxVal) {
     int nCol = fColorCount/2;
     int iValue = nCol*(value - minVal)/(maxVal - minVal);
@@ -5,6 +5,13 @@ namespace CP {
     class TEventDisplay;
     class TGUIManager;
     class TEventChangeManager;
+    class TTaskPool;
+    class TTimingTable;
+    class TEvePool;
+    class TEventSummary;
+    class THandleCache;
+    class TFrameBudget;
+    class TGeometryVoxels;
     class TPlotHitSamples;
     class TPlotDigitsHits;
     class TPlotTimeCharge;
@@ -27,6 +34,41 @@ public:
     /// Return a reference to the event change manager.
     CP::TEventChangeManager& EventChange() {return *fEventChangeManager;}
 
+    /// Return a reference to the pool of threads used to build the event.
+    CP::TTaskPool& Tasks() {return *fTaskPool;}
+
+    /// Return a reference to the table of the time spent drawing events.
+    CP::TTimingTable& Timing() {return *fTimingTable;}
+
+    /// Return a reference to the pool of Eve elements reused between events.
+    CP::TEvePool& Pool() {return *fEvePool;}
+
+    /// Return a reference to the summary of the current event used by the
+    /// plots.
+    CP::TEventSummary& Summary() {return *fEventSummary;}
+
+    /// Return a reference to the cache of handles found in the current
+    /// event.
+    CP::THandleCache& Handles() {return *fHandleCache;}
+
+    /// Return a reference to the budget that chooses the level of detail.
+    CP::TFrameBudget& Budget() {return *fFrameBudget;}
+
+    /// Return a reference to the grid used to find the geometry id of a
+    /// point.
+    CP::TGeometryVoxels& Voxels() {return *fGeometryVoxels;}
+
+    /// Get a number that changes each time a new geometry is loaded.  The
+    /// values saved for a geometry (e.g. by CP::TLiquidVolume) are checked
+    /// against this, since a new geometry can be created at the same
+    /// address as the old one.
+    int GetGeometrySerial() const {return fGeometrySerial;}
+
+    /// Note that a new geometry has been loaded, and start building the
+    /// voxels for it.  This is called by the geometry change callback of
+    /// the CP::TEventChangeManager.
+    void GeometryChanged();
+
     /// Get a color from the palette using a linear value scale.
     int LinearColor(double val, double minVal, double maxVal);
 
@@ -52,6 +94,30 @@ private:
     // The event change manager.
     TEventChangeManager* fEventChangeManager;
 
+    // The pool of threads used by the event change handlers.
+    TTaskPool* fTaskPool;
+
+    // The time spent drawing the recent events.
+    TTimingTable* fTimingTable;
+
+    // The Eve elements that are reused between events.
+    TEvePool* fEvePool;
+
+    // The values derived from the current event that are used by the plots.
+    TEventSummary* fEventSummary;
+
+    // The handles found in the current event.
+    THandleCache* fHandleCache;
+
+    // The budget that chooses the level of detail.
+    TFrameBudget* fFrameBudget;
+
+    // The grid used to find geometry ids.
+    TGeometryVoxels* fGeometryVoxels;
+
+    // The number of geometries that have been loaded.
+    int fGeometrySerial;
+
     // The hit drawing class.  This is connected directly to the button.
     TPlotHitSamples* fPlotHitSamples;
     
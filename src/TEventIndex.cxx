@@ -0,0 +1,240 @@
+#include "TEventIndex.hxx"
+#include "TEventPrefetch.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <TEventContext.hxx>
+#include <TRootInput.hxx>
+
+#include <TSystem.h>
+#include <TThread.h>
+#include <TVirtualMutex.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    /// The first bytes of an index sidecar.  This is changed if the format
+    /// of the file changes.
+    const char sidecarMagic[8] = {'C','P','E','V','I','D','X','2'};
+
+    /// Read the sidecar header, and check that it matches the input file.
+    /// This returns the number of entries, or -1 if the sidecar can't be
+    /// used.
+    int ReadSidecarHeader(std::istream& input,
+                          Long64_t fileSize, Long64_t fileTime) {
+        char magic[sizeof(sidecarMagic)];
+        Long64_t sidecarSize;
+        Long64_t sidecarTime;
+        Int_t entries;
+        input.read(magic, sizeof(magic));
+        input.read(reinterpret_cast<char*>(&sidecarSize), sizeof(sidecarSize));
+        input.read(reinterpret_cast<char*>(&sidecarTime), sizeof(sidecarTime));
+        input.read(reinterpret_cast<char*>(&entries), sizeof(entries));
+        if (!input.good()) return -1;
+        if (!std::equal(magic, magic+sizeof(magic), sidecarMagic)) return -1;
+        if (sidecarSize != fileSize || sidecarTime != fileTime) return -1;
+        return entries;
+    }
+};
+
+CP::TEventIndex::TEventIndex(CP::TRootInput* input)
+    : fInput(input), fFileSize(0), fFileTime(0), fEntryCount(0),
+      fStop(false), fLock(kTRUE), fThread(NULL) {
+    {
+        TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
+        fFileName = fInput->GetInputName();
+        fEntryCount = fInput->GetEventsInFile();
+    }
+
+    FileStat_t stat;
+    if (gSystem->GetPathInfo(fFileName.c_str(), stat) == 0) {
+        fFileSize = stat.fSize;
+        fFileTime = stat.fMtime;
+    }
+
+    if (ReadSidecar()) {
+        CaptLog("Read event index from " << GetSidecarName(fFileName));
+        return;
+    }
+
+    CaptLog("Index " << fEntryCount << " entries in " << fFileName);
+    TThread::Initialize();
+    fThread = new TThread("eventIndex",
+                          &CP::TEventIndex::ThreadFunction,
+                          this);
+    fThread->Run();
+}
+
+CP::TEventIndex::~TEventIndex() {
+    fLock.Lock();
+    fStop = true;
+    fLock.UnLock();
+    Wait();
+}
+
+std::string CP::TEventIndex::GetSidecarName(const std::string& fileName) {
+    return fileName + ".idx";
+}
+
+int CP::TEventIndex::GetSidecarEntryCount(const std::string& fileName) {
+    FileStat_t stat;
+    if (gSystem->GetPathInfo(fileName.c_str(), stat) != 0) return -1;
+    std::ifstream input(GetSidecarName(fileName).c_str(),
+                        std::ios::in | std::ios::binary);
+    if (!input.is_open()) return -1;
+    return ReadSidecarHeader(input, stat.fSize, stat.fMtime);
+}
+
+bool CP::TEventIndex::ParseEventName(const std::string& name,
+                                     int& run, int& event) {
+    std::size_t sep = name.find(".");
+    if (sep == std::string::npos) return false;
+    std::istringstream runStream(name.substr(0,sep));
+    std::istringstream eventStream(name.substr(sep+1));
+    if (!(runStream >> run)) return false;
+    if (!(eventStream >> event)) return false;
+    return true;
+}
+
+int CP::TEventIndex::GetEntry(int run, int event) {
+    TLockGuard guard(&fLock);
+    std::map< std::pair<int,int>, int >::iterator e
+        = fEntries.find(std::make_pair(run,event));
+    if (e == fEntries.end()) return -1;
+    return e->second;
+}
+
+bool CP::TEventIndex::IsComplete() {
+    TLockGuard guard(&fLock);
+    return ((int) fEntryEvents.size() >= fEntryCount);
+}
+
+void CP::TEventIndex::Wait() {
+    if (!fThread) return;
+    fThread->Join();
+    delete fThread;
+    fThread = NULL;
+}
+
+void* CP::TEventIndex::ThreadFunction(void* arg) {
+    CP::TEventIndex* index = static_cast<CP::TEventIndex*>(arg);
+    index->Scan();
+    return NULL;
+}
+
+void CP::TEventIndex::AddEntry(int run, int event) {
+    int entry = fEntryEvents.size();
+    std::pair<int,int> key(run,event);
+    fEntryEvents.push_back(key);
+    // Keep the first entry if a run and event number is repeated.
+    if (fEntries.find(key) == fEntries.end()) fEntries[key] = entry;
+}
+
+void CP::TEventIndex::Scan() {
+    for (int entry = 0; entry < fEntryCount; ++entry) {
+        int run = -1;
+        int event = -1;
+        {
+            // Each entry is read while holding the event lock so that the
+            // display and the prefetch can interleave with the scan.
+            TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
+            CP::TEvent* ev = fInput->ReadEvent(entry);
+            if (ev) {
+                CP::TEventPrefetch::DetachEvent(ev);
+                run = ev->GetContext().GetRun();
+                event = ev->GetContext().GetEvent();
+                delete ev;
+            }
+        }
+        TLockGuard guard(&fLock);
+        if (fStop) return;
+        AddEntry(run, event);
+    }
+    CaptLog("Finished indexing " << fFileName);
+    WriteSidecar();
+}
+
+bool CP::TEventIndex::ReadSidecar() {
+    std::ifstream input(GetSidecarName(fFileName).c_str(),
+                        std::ios::in | std::ios::binary);
+    if (!input.is_open()) return false;
+
+    int entries = ReadSidecarHeader(input, fFileSize, fFileTime);
+    if (entries < 0) {
+        CaptLog("Event index is out of date for " << fFileName);
+        return false;
+    }
+    if (entries != fEntryCount) return false;
+
+    TLockGuard guard(&fLock);
+    for (int i = 0; i < entries; ++i) {
+        Int_t record[2];
+        input.read(reinterpret_cast<char*>(record), sizeof(record));
+        if (!input.good()) {
+            CaptError("Corrupt event index for " << fFileName);
+            fEntries.clear();
+            fEntryEvents.clear();
+            return false;
+        }
+        AddEntry(record[0], record[1]);
+    }
+    return true;
+}
+
+bool CP::TEventIndex::WriteSidecar() {
+    std::vector< std::pair<int,int> > events;
+    {
+        TLockGuard guard(&fLock);
+        events = fEntryEvents;
+    }
+    return WriteSidecar(fFileName, fFileSize, fFileTime, events);
+}
+
+bool CP::TEventIndex::WriteSidecar(
+    const std::string& fileName,
+    const std::vector< std::pair<int,int> >& events) {
+    FileStat_t stat;
+    if (gSystem->GetPathInfo(fileName.c_str(), stat) != 0) return false;
+    return WriteSidecar(fileName, stat.fSize, stat.fMtime, events);
+}
+
+bool CP::TEventIndex::WriteSidecar(
+    const std::string& fileName,
+    Long64_t fileSize, Long64_t fileTime,
+    const std::vector< std::pair<int,int> >& events) {
+    // The sidecar is written under a temporary name and then renamed, so
+    // another event display never reads a partial file.
+    std::string name = GetSidecarName(fileName);
+    std::ostringstream tempName;
+    tempName << name << "." << gSystem->GetPid() << ".tmp";
+    std::ofstream output(tempName.str().c_str(),
+                         std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        CaptWarn("Cannot write event index to " << name);
+        return false;
+    }
+
+    Int_t entries = events.size();
+    output.write(sidecarMagic, sizeof(sidecarMagic));
+    output.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
+    output.write(reinterpret_cast<const char*>(&fileTime), sizeof(fileTime));
+    output.write(reinterpret_cast<const char*>(&entries), sizeof(entries));
+    for (int i = 0; i < entries; ++i) {
+        Int_t record[2] = {events[i].first, events[i].second};
+        output.write(reinterpret_cast<const char*>(record), sizeof(record));
+    }
+    output.close();
+    if (output.fail()) {
+        CaptWarn("Error writing event index to " << name);
+        gSystem->Unlink(tempName.str().c_str());
+        return false;
+    }
+    if (gSystem->Rename(tempName.str().c_str(), name.c_str()) != 0) {
+        CaptWarn("Cannot rename event index to " << name);
+        gSystem->Unlink(tempName.str().c_str());
+        return false;
+    }
+    return true;
+}
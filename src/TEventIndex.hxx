@@ -0,0 +1,118 @@
+#ifndef TEventIndex_hxx_seen
+#define TEventIndex_hxx_seen
+
+#include <TMutex.h>
+#include <Rtypes.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace CP {
+    class TEventIndex;
+    class TRootInput;
+};
+
+class TThread;
+
+/// An index of the events in an input file that maps a run and event number
+/// to the entry number in the file.
+///
+/// The index is saved in a sidecar file next to the input file (the input
+/// file name with ".idx" appended).  If a sidecar exists, and matches the
+/// size and modification time of the input file, it is loaded directly.
+/// Otherwise, the input file is scanned once by a worker thread and the
+/// sidecar is written when the scan finishes (under a temporary name that is
+/// then renamed, so a partial sidecar is never read).  Entries can be looked
+/// up while the scan is running.
+class CP::TEventIndex {
+public:
+    /// Create the index for an input file.  This does not take ownership of
+    /// the input.
+    explicit TEventIndex(CP::TRootInput* input);
+    ~TEventIndex();
+
+    /// Get the entry number for a run and event, or -1 if the event isn't in
+    /// the index (yet).
+    int GetEntry(int run, int event);
+
+    /// Check if the index contains all of the entries in the file.
+    bool IsComplete();
+
+    /// Wait for the scan of the file to finish.
+    void Wait();
+
+    /// Parse a "run.event" string into the run and event numbers.  This
+    /// returns false if the string can't be parsed.
+    static bool ParseEventName(const std::string& name, int& run, int& event);
+
+    /// Get the number of entries saved in the sidecar for an input file, or
+    /// -1 if there isn't an up to date sidecar.  This doesn't open the input
+    /// file.
+    static int GetSidecarEntryCount(const std::string& fileName);
+
+    /// Get the name of the sidecar file for an input file.
+    static std::string GetSidecarName(const std::string& fileName);
+
+    /// Write the sidecar for an input file from the run and event number of
+    /// each entry (e.g. after the file has been scanned by a
+    /// CP::TEventChain).  This returns false if the sidecar can't be
+    /// written.
+    static bool WriteSidecar(const std::string& fileName,
+                             const std::vector< std::pair<int,int> >& events);
+
+private:
+    /// The function run by the worker thread.
+    static void* ThreadFunction(void* arg);
+
+    /// Scan the input file and then write the sidecar.
+    void Scan();
+
+    /// Read the sidecar if it exists and matches the input file.  This
+    /// returns false if the file needs to be scanned.
+    bool ReadSidecar();
+
+    /// Write the sidecar file.
+    bool WriteSidecar();
+
+    /// Write a sidecar file for an input file with a size and modification
+    /// time.
+    static bool WriteSidecar(const std::string& fileName,
+                             Long64_t fileSize, Long64_t fileTime,
+                             const std::vector< std::pair<int,int> >& events);
+
+    /// Add an entry to the index.  This must be called while holding fLock.
+    void AddEntry(int run, int event);
+
+    /// The input being indexed.
+    CP::TRootInput* fInput;
+
+    /// The name of the input file.
+    std::string fFileName;
+
+    /// The size of the input file when it was indexed.
+    Long64_t fFileSize;
+
+    /// The modification time of the input file when it was indexed.
+    Long_t fFileTime;
+
+    /// The number of entries in the input file.
+    int fEntryCount;
+
+    /// The map from the run and event number to the entry.
+    std::map< std::pair<int,int>, int > fEntries;
+
+    /// The run and event number for each entry.
+    std::vector< std::pair<int,int> > fEntryEvents;
+
+    /// A flag to tell the worker thread to stop.
+    bool fStop;
+
+    /// The lock protecting the index.
+    TMutex fLock;
+
+    /// The worker thread scanning the file (NULL if a sidecar was read).
+    TThread* fThread;
+};
+#endif
@@ -0,0 +1,579 @@
+#include "TEventPrefetch.hxx"
+#include "TEventChain.hxx"
+#include "TEventCache.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <TEventFolder.hxx>
+#include <TRootInput.hxx>
+#include <TRuntimeParameters.hxx>
+#include <TVInputFile.hxx>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TThread.h>
+#include <TVirtualMutex.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+    /// Remove the "~/" (or "/") at the start of an event path.
+    std::string NormalizePath(const std::string& path) {
+        std::string result(path);
+        if (result.compare(0,1,"~") == 0) result.erase(0,1);
+        while (!result.empty() && result[0] == '/') result.erase(0,1);
+        return result;
+    }
+
+    /// Check if a folder is inside one of the paths, or contains one of the
+    /// paths.
+    bool IsNeeded(const std::string& folder,
+                  const std::vector<std::string>& paths) {
+        for (std::vector<std::string>::const_iterator p = paths.begin();
+             p != paths.end(); ++p) {
+            std::string path = NormalizePath(*p);
+            if (path.empty()) return true;
+            if (path == folder) return true;
+            if (path.compare(0, folder.size()+1, folder + "/") == 0) {
+                return true;
+            }
+            if (folder.compare(0, path.size()+1, path + "/") == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Remove a folder (e.g. "digits/drift") from an event and delete it.
+    /// This returns false if the event doesn't have the folder.
+    bool RemoveFolder(CP::TEvent* event, const std::string& folder) {
+        CP::TDataVector* parent = event;
+        std::string name = folder;
+        std::size_t sep = folder.rfind('/');
+        if (sep != std::string::npos) {
+            CP::THandle<CP::TDataVector> handle
+                = event->Get<CP::TDataVector>(folder.substr(0,sep).c_str());
+            if (!handle) return false;
+            parent = CP::GetPointer(handle);
+            name = folder.substr(sep+1);
+        }
+        for (CP::TDataVector::iterator d = parent->begin();
+             d != parent->end(); ++d) {
+            if (name != (*d)->GetName()) continue;
+            CP::TDatum* datum = *d;
+            parent->erase(d);
+            delete datum;
+            return true;
+        }
+        return false;
+    }
+};
+
+CP::TEventPrefetch::TEventPrefetch(CP::TVInputFile* source,
+                                   int nextCount, int previousCount)
+    : fEventSource(source), fEntryCount(0),
+      fNextCount(std::max(0,nextCount)),
+      fPreviousCount(std::max(0,previousCount)),
+      fCurrentEntry(0), fReadingEntry(-1), fAttachedEvent(NULL), fHolds(0),
+      fCache(NULL), fHitCount(0), fMissCount(0),
+      fIndexing(true), fStop(false), fLock(kTRUE), fWakeUp(&fLock),
+      fReady(&fLock), fThread(NULL) {
+    fRing.resize(fNextCount + fPreviousCount + 1);
+
+    int cacheSize = CP::TRuntimeParameters::Get().GetParameterI(
+        "eventDisplay.cache.size");
+    if (cacheSize > 0) {
+        fCache = new CP::TEventCache(Long64_t(cacheSize)*1024*1024);
+    }
+
+    // Keep the whole event until the display says what it needs.
+    fEventPaths.push_back("~");
+    std::istringstream folders(CP::TRuntimeParameters::Get().GetParameterS(
+                                   "eventDisplay.lazy.folders"));
+    std::string folder;
+    while (std::getline(folders, folder, ',')) {
+        folder = NormalizePath(folder);
+        if (!folder.empty()) fLazyFolders.push_back(folder);
+    }
+
+    {
+        TLockGuard guard(&GetEventLock());
+        fEntryCount = GetSourceEntryCount(fEventSource);
+    }
+
+    // Make sure ROOT knows that there is more than one thread.
+    TThread::Initialize();
+    fThread = new TThread("eventPrefetch",
+                          &CP::TEventPrefetch::ThreadFunction,
+                          this);
+    fThread->Run();
+}
+
+CP::TEventPrefetch::~TEventPrefetch() {
+    fLock.Lock();
+    fStop = true;
+    fWakeUp.Broadcast();
+    fLock.UnLock();
+    if (fThread) {
+        fThread->Join();
+        delete fThread;
+    }
+
+    std::vector<CP::TEvent*> doomed;
+    for (std::vector<Slot>::iterator s = fRing.begin();
+         s != fRing.end(); ++s) {
+        if (s->event) doomed.push_back(s->event);
+        s->event = NULL;
+    }
+    if (fCache) {
+        fCache->Clear(doomed);
+        delete fCache;
+    }
+    doomed.insert(doomed.end(), fReplaced.begin(), fReplaced.end());
+    fReplaced.clear();
+    DeleteEvents(doomed);
+}
+
+bool CP::TEventPrefetch::IsRandomAccess(CP::TVInputFile* source) {
+    if (dynamic_cast<CP::TRootInput*>(source)) return true;
+    if (dynamic_cast<CP::TEventChain*>(source)) return true;
+    return false;
+}
+
+TMutex& CP::TEventPrefetch::GetEventLock() {
+    static TMutex eventLock(kTRUE);
+    return eventLock;
+}
+
+void CP::TEventPrefetch::DetachEvent(CP::TEvent* event) {
+    if (!event) return;
+    CP::TEventFolder* folder = CP::TEventFolder::GetEventFolder();
+    if (folder) folder->Remove(event);
+}
+
+void CP::TEventPrefetch::AttachEvent(CP::TEvent* event) {
+    if (!event) return;
+    CP::TEventFolder* folder = CP::TEventFolder::GetEventFolder();
+    if (folder) folder->Add(event);
+}
+
+int CP::TEventPrefetch::GetEntryCount() {
+    return fEntryCount;
+}
+
+int CP::TEventPrefetch::GetHitCount() {
+    TLockGuard guard(&fLock);
+    return fHitCount;
+}
+
+int CP::TEventPrefetch::GetMissCount() {
+    TLockGuard guard(&fLock);
+    return fMissCount;
+}
+
+Long64_t CP::TEventPrefetch::GetCacheBytes() {
+    TLockGuard guard(&fLock);
+    if (!fCache) return 0;
+    return fCache->GetBytes();
+}
+
+void CP::TEventPrefetch::DeleteEvents(std::vector<CP::TEvent*>& events) {
+    if (events.empty()) return;
+    TLockGuard guard(&GetEventLock());
+    for (std::vector<CP::TEvent*>::iterator e = events.begin();
+         e != events.end(); ++e) {
+        delete (*e);
+    }
+    events.clear();
+}
+
+void* CP::TEventPrefetch::ThreadFunction(void* arg) {
+    CP::TEventPrefetch* prefetch = static_cast<CP::TEventPrefetch*>(arg);
+    prefetch->Run();
+    return NULL;
+}
+
+void CP::TEventPrefetch::Run() {
+    fLock.Lock();
+    while (!fStop) {
+        int entry = NextEntryToRead();
+        if (entry < 0) {
+            // Index the input files while there's nothing to read.
+            if (fIndexing) {
+                fLock.UnLock();
+                {
+                    TLockGuard guard(&GetEventLock());
+                    CP::TEventChain* chain
+                        = dynamic_cast<CP::TEventChain*>(fEventSource);
+                    fIndexing = chain && chain->IndexStep();
+                }
+                fLock.Lock();
+                continue;
+            }
+            fWakeUp.Wait();
+            continue;
+        }
+        // Use the cached copy of the entry if there is one.
+        std::vector<CP::TEvent*> doomed;
+        bool cached = TakeFromCache(entry, doomed);
+        if (!doomed.empty()) {
+            // The event lock is never taken while holding fLock, and the
+            // ring may change while it's released, so start over.
+            fLock.UnLock();
+            DeleteEvents(doomed);
+            fLock.Lock();
+            continue;
+        }
+        if (cached) continue;
+        fReadingEntry = entry;
+        std::vector<std::string> needed(fEventPaths);
+        fLock.UnLock();
+        Slot result;
+        ReadEntry(entry, needed, result);
+        fLock.Lock();
+        fReadingEntry = -1;
+        Store(result, doomed);
+        fReady.Broadcast();
+        if (!doomed.empty()) {
+            fLock.UnLock();
+            DeleteEvents(doomed);
+            fLock.Lock();
+        }
+    }
+    fLock.UnLock();
+}
+
+CP::TEvent* CP::TEventPrefetch::ReadSourceEntry(CP::TVInputFile* source,
+                                                int entry) {
+    CP::TEvent* event = NULL;
+    CP::TRootInput* input = dynamic_cast<CP::TRootInput*>(source);
+    if (input) event = input->ReadEvent(entry);
+    CP::TEventChain* chain = dynamic_cast<CP::TEventChain*>(source);
+    if (chain) event = chain->ReadEvent(entry);
+    if (!event) {
+        CaptError("Unable to read entry " << entry);
+        return NULL;
+    }
+    DetachEvent(event);
+    return event;
+}
+
+int CP::TEventPrefetch::GetSourceEntryCount(CP::TVInputFile* source) {
+    CP::TRootInput* input = dynamic_cast<CP::TRootInput*>(source);
+    if (input) return input->GetEventsInFile();
+    CP::TEventChain* chain = dynamic_cast<CP::TEventChain*>(source);
+    if (chain) return chain->GetEventsInFile();
+    return 0;
+}
+
+int CP::TEventPrefetch::RefreshSource(CP::TVInputFile* source) {
+    CP::TRootInput* input = dynamic_cast<CP::TRootInput*>(source);
+    if (!input) return GetSourceEntryCount(source);
+    TFile* file = input->GetFilePointer();
+    if (!file) return GetSourceEntryCount(source);
+
+    // The event tree was loaded into the file directory when the input was
+    // opened.  Refreshing it rereads the tree header, so the entries that
+    // the writer has committed since then become visible.
+    TIter next(file->GetList());
+    while (TObject* obj = next()) {
+        TTree* tree = dynamic_cast<TTree*>(obj);
+        if (tree) tree->Refresh();
+    }
+    return GetSourceEntryCount(source);
+}
+
+int CP::TEventPrefetch::Refresh() {
+    int entries;
+    {
+        TLockGuard guard(&GetEventLock());
+        entries = RefreshSource(fEventSource);
+    }
+    TLockGuard guard(&fLock);
+    if (entries > fEntryCount) {
+        CaptLog("Found " << entries - fEntryCount << " new entries");
+        fEntryCount = entries;
+        fWakeUp.Broadcast();
+    }
+    return fEntryCount;
+}
+
+CP::TEvent* CP::TEventPrefetch::ReadEntry(
+    int entry,
+    const std::vector<std::string>& needed,
+    Slot& result) {
+    result = Slot();
+    result.entry = entry;
+    TLockGuard guard(&GetEventLock());
+    result.event = ReadSourceEntry(fEventSource, entry);
+    if (!result.event) return NULL;
+    for (std::vector<std::string>::iterator f = fLazyFolders.begin();
+         f != fLazyFolders.end(); ++f) {
+        if (IsNeeded(*f, needed)) continue;
+        if (RemoveFolder(result.event, *f)) result.pruned.push_back(*f);
+    }
+    // The size is only needed to budget the cache.  It's estimated after
+    // the folders are removed so that only the memory that is kept is
+    // charged.
+    if (fCache) result.bytes = CP::TEventCache::GetEventBytes(*result.event);
+    return result.event;
+}
+
+bool CP::TEventPrefetch::HasPaths(const std::vector<std::string>& pruned,
+                                  const std::vector<std::string>& paths) {
+    for (std::vector<std::string>::const_iterator f = pruned.begin();
+         f != pruned.end(); ++f) {
+        if (IsNeeded(*f, paths)) return false;
+    }
+    return true;
+}
+
+void CP::TEventPrefetch::SetEventPaths(const std::vector<std::string>& paths) {
+    std::vector<CP::TEvent*> stale;
+    fLock.Lock();
+    fEventPaths = paths;
+
+    // Drop the events that are missing a folder that is now needed so that
+    // the worker reads them again.  The current event is handled by
+    // LoadEventPaths(), and the cached events are checked when they are
+    // taken out of the cache.
+    for (std::vector<Slot>::iterator s = fRing.begin();
+         s != fRing.end(); ++s) {
+        if (!s->event || s->entry == fCurrentEntry) continue;
+        if (HasPaths(s->pruned, fEventPaths)) continue;
+        stale.push_back(s->event);
+        (*s) = Slot();
+    }
+    fWakeUp.Broadcast();
+    fLock.UnLock();
+
+    DeleteEvents(stale);
+
+    LoadEventPaths(paths);
+}
+
+void CP::TEventPrefetch::HoldEvent() {
+    TLockGuard guard(&fLock);
+    ++fHolds;
+}
+
+void CP::TEventPrefetch::ReleaseEvent() {
+    TLockGuard guard(&fLock);
+    if (fHolds > 0) --fHolds;
+}
+
+CP::TEvent* CP::TEventPrefetch::LoadEventPaths(
+    const std::vector<std::string>& paths) {
+    fLock.Lock();
+    if (fHolds > 0) {
+        CaptError("Current event is in use and cannot be read again");
+        CP::TEvent* event = fAttachedEvent;
+        fLock.UnLock();
+        return event;
+    }
+    int entry = fCurrentEntry;
+    Slot& slot = fRing[entry % fRing.size()];
+    if (slot.entry != entry || !slot.event
+        || HasPaths(slot.pruned, paths)) {
+        CP::TEvent* event = fAttachedEvent;
+        fLock.UnLock();
+        return event;
+    }
+
+    CaptLog("Read entry " << entry << " again for the missing folders");
+    std::vector<std::string> needed(fEventPaths);
+    needed.insert(needed.end(), paths.begin(), paths.end());
+    fLock.UnLock();
+    Slot result;
+    CP::TEvent* event = ReadEntry(entry, needed, result);
+    // Replace the current event with the complete one.  Only the GUI
+    // thread changes the current entry, so the slot still holds it.  The
+    // elements drawn for the old event may still point into it, so it's
+    // kept until DeleteReplacedEvents().
+    CP::TEvent* old = NULL;
+    fLock.Lock();
+    if (event && slot.entry == entry) {
+        old = slot.event;
+        fReplaced.push_back(old);
+        slot = result;
+    }
+    fLock.UnLock();
+
+    // The event lock is never taken while holding fLock.
+    TLockGuard guard(&GetEventLock());
+    if (!old) {
+        delete event;
+        return fAttachedEvent;
+    }
+    if (old == fAttachedEvent) {
+        DetachEvent(fAttachedEvent);
+        fAttachedEvent = event;
+        AttachEvent(fAttachedEvent);
+    }
+    return fAttachedEvent;
+}
+
+void CP::TEventPrefetch::DeleteReplacedEvents() {
+    std::vector<CP::TEvent*> doomed;
+    {
+        TLockGuard guard(&fLock);
+        doomed.swap(fReplaced);
+    }
+    DeleteEvents(doomed);
+}
+
+bool CP::TEventPrefetch::IsLoaded(const std::vector<std::string>& paths) {
+    TLockGuard guard(&fLock);
+    Slot& slot = fRing[fCurrentEntry % fRing.size()];
+    if (slot.entry != fCurrentEntry || !slot.event) return true;
+    return HasPaths(slot.pruned, paths);
+}
+
+bool CP::TEventPrefetch::InWindow(int entry) const {
+    if (entry < 0) return false;
+    if (entry >= fEntryCount) return false;
+    if (entry < fCurrentEntry - fPreviousCount) return false;
+    if (entry > fCurrentEntry + fNextCount) return false;
+    return true;
+}
+
+int CP::TEventPrefetch::NextEntryToRead() const {
+    // Look forward first since that is the usual direction to scan a file,
+    // then fill in the previous events.
+    for (int i = 1; i <= fNextCount; ++i) {
+        int entry = fCurrentEntry + i;
+        if (!InWindow(entry)) break;
+        if (fRing[entry % fRing.size()].entry != entry) return entry;
+    }
+    for (int i = 1; i <= fPreviousCount; ++i) {
+        int entry = fCurrentEntry - i;
+        if (!InWindow(entry)) break;
+        if (fRing[entry % fRing.size()].entry != entry) return entry;
+    }
+    return -1;
+}
+
+void CP::TEventPrefetch::Store(Slot& result,
+                               std::vector<CP::TEvent*>& doomed) {
+    if (!result.event) return;
+    Slot& slot = fRing[result.entry % fRing.size()];
+    if (slot.entry == result.entry || !HasPaths(result.pruned, fEventPaths)) {
+        // The entry was read twice, or the display now needs a folder that
+        // was removed, so the event isn't needed.
+        doomed.push_back(result.event);
+    }
+    else if (!InWindow(result.entry)) {
+        // The display moved on while the entry was being read.
+        Retire(result, doomed);
+    }
+    else {
+        Retire(slot, doomed);
+        slot = result;
+    }
+    result = Slot();
+}
+
+void CP::TEventPrefetch::Retire(Slot& slot,
+                                std::vector<CP::TEvent*>& doomed) {
+    if (slot.event) {
+        if (fCache) {
+            fCache->Insert(slot.entry, slot.event, slot.bytes, slot.pruned,
+                           doomed);
+        }
+        else doomed.push_back(slot.event);
+    }
+    slot = Slot();
+}
+
+bool CP::TEventPrefetch::TakeFromCache(int entry,
+                                       std::vector<CP::TEvent*>& doomed) {
+    if (!fCache) return false;
+    Slot cached;
+    cached.entry = entry;
+    cached.event = fCache->Take(entry, cached.bytes, cached.pruned);
+    if (!cached.event) return false;
+    if (!HasPaths(cached.pruned, fEventPaths)) {
+        doomed.push_back(cached.event);
+        return false;
+    }
+    Slot& slot = fRing[entry % fRing.size()];
+    Retire(slot, doomed);
+    slot = cached;
+    return true;
+}
+
+CP::TEvent* CP::TEventPrefetch::GetEvent(int entry) {
+    if (entry < 0 || entry >= fEntryCount) return NULL;
+
+    {
+        TLockGuard guard(&fLock);
+        if (fHolds > 0) {
+            CaptError("Current event is in use and cannot be replaced");
+            return NULL;
+        }
+    }
+
+    // Detach the old event first since it may be pushed out of the cache
+    // (and deleted) below.  The event lock is never taken while holding
+    // fLock.  The attached event is only changed by the GUI thread, and it
+    // stays in the ring until the current entry changes.
+    {
+        TLockGuard guard(&GetEventLock());
+        if (fAttachedEvent) DetachEvent(fAttachedEvent);
+        fAttachedEvent = NULL;
+    }
+
+    fLock.Lock();
+    fCurrentEntry = entry;
+
+    // Move the events that have dropped out of the ring into the cache.
+    std::vector<CP::TEvent*> doomed;
+    for (std::vector<Slot>::iterator s = fRing.begin();
+         s != fRing.end(); ++s) {
+        if (!s->event || InWindow(s->entry)) continue;
+        Retire(*s, doomed);
+    }
+
+    // Wait if the worker is reading the requested entry right now.
+    while (fReadingEntry == entry) fReady.Wait();
+
+    Slot& slot = fRing[entry % fRing.size()];
+    if (slot.entry == entry || TakeFromCache(entry, doomed)) {
+        ++fHitCount;
+    }
+    else {
+        // The entry isn't in memory, so read it here.
+        ++fMissCount;
+        CaptLog("Prefetch miss for entry " << entry);
+        std::vector<std::string> needed(fEventPaths);
+        fLock.UnLock();
+        Slot result;
+        ReadEntry(entry, needed, result);
+        fLock.Lock();
+        Store(result, doomed);
+    }
+    CP::TEvent* event = (slot.entry == entry) ? slot.event : NULL;
+
+    if (fCache) {
+        CaptInfo("Event cache: " << fHitCount << " hits, "
+                 << fMissCount << " misses, "
+                 << fCache->GetEventCount() << " events using "
+                 << fCache->GetBytes()/1024/1024 << " MB");
+    }
+
+    // Tell the worker where the display is now.
+    fWakeUp.Broadcast();
+    fLock.UnLock();
+
+    // The new current event stays in the ring until the GUI thread changes
+    // the current entry again, so it's safe to use without fLock.
+    DeleteEvents(doomed);
+    {
+        TLockGuard guard(&GetEventLock());
+        fAttachedEvent = event;
+        AttachEvent(fAttachedEvent);
+    }
+
+    return event;
+}
@@ -0,0 +1,273 @@
+#ifndef TEventPrefetch_hxx_seen
+#define TEventPrefetch_hxx_seen
+
+#include <TMutex.h>
+#include <TCondition.h>
+
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TEventPrefetch;
+    class TEvent;
+    class TVInputFile;
+    class TEventCache;
+};
+
+class TThread;
+
+/// Read events on a worker thread so that they are already decoded when the
+/// display moves to them.  The prefetcher keeps a bounded ring of events
+/// around the current entry (the next "nextCount" entries and the previous
+/// "previousCount" entries), and a worker thread fills any empty slot in the
+/// ring while the display is idle.  The GUI thread only blocks when it asks
+/// for an entry that isn't in the ring yet.  When the ring is full, the
+/// worker indexes the files of a CP::TEventChain that don't have a sidecar
+/// yet (see CP::TEventChain::IndexStep()).
+///
+/// The prefetcher only keeps the event folders that the display needs (see
+/// SetEventPaths()).  The large folders listed in the
+/// "eventDisplay.lazy.folders" parameter (e.g. the digits and the truth
+/// information) are removed from each event after it is read unless a path
+/// needs them.  When a folder is needed later, the event is read again.
+/// Since the event is saved as a single object in the file, this reduces the
+/// memory used by the events being held, but not the number of bytes read.
+///
+/// Events that drop out of the ring are kept in a CP::TEventCache with a
+/// memory budget set by the "eventDisplay.cache.size" parameter (in MB), so
+/// going back to a recently viewed event doesn't read it again.
+///
+/// The events read by the prefetcher are removed from the CP::TEventFolder so
+/// that CP::TEventFolder::GetCurrentEvent() continues to return the event
+/// being shown.  The event returned by GetEvent() is put back into the folder
+/// and becomes the current event.
+///
+/// \note ROOT I/O and the event folder are not thread safe, so all access to
+/// the input file and to the event folder must be done while holding the lock
+/// returned by GetEventLock().  The event lock is never taken while holding
+/// the lock that protects the ring (fLock), so the events that need to be
+/// deleted are collected and deleted after fLock is released.
+class CP::TEventPrefetch {
+public:
+    /// Create a prefetcher for an input source.  The source must be random
+    /// access (see IsRandomAccess()).  The prefetcher does not take ownership
+    /// of the source.
+    TEventPrefetch(CP::TVInputFile* source, int nextCount, int previousCount);
+    ~TEventPrefetch();
+
+    /// Check if an input source can be read by entry number.  Only random
+    /// access sources (a CP::TRootInput or a CP::TEventChain) can be
+    /// prefetched.
+    static bool IsRandomAccess(CP::TVInputFile* source);
+
+    /// Get the event for an entry, and make it the current event.  This
+    /// blocks if the entry hasn't been read yet.  The event is owned by the
+    /// prefetcher and remains valid until GetEvent() is called for an entry
+    /// far enough away that the event drops out of the ring.  This returns
+    /// NULL if the entry can't be read.
+    CP::TEvent* GetEvent(int entry);
+
+    /// Get the number of entries in the input source.
+    int GetEntryCount();
+
+    /// Get the number of times GetEvent() found the event in memory (in the
+    /// ring or the cache).
+    int GetHitCount();
+
+    /// Get the number of times GetEvent() had to wait for the event to be
+    /// read.
+    int GetMissCount();
+
+    /// Get the estimated memory used by the events in the cache.
+    Long64_t GetCacheBytes();
+
+    /// Set the event paths (e.g. "~/hits/drift") that the display needs.
+    /// The large folders that aren't needed are removed from the events held
+    /// by the prefetcher.  If the current event is missing a folder that is
+    /// now needed, it is read again.  The default is to keep the whole event
+    /// (a path of "~").
+    void SetEventPaths(const std::vector<std::string>& paths);
+
+    /// Make sure that the current event contains the folders for the paths
+    /// (reading it again if necessary) without changing the paths that are
+    /// kept for other events.  This returns the current event.  The event
+    /// that is replaced isn't deleted, since the Eve elements drawn for it
+    /// may still point into it (e.g. the digit ids of the drift hits), and
+    /// is kept until DeleteReplacedEvents() is called.
+    CP::TEvent* LoadEventPaths(const std::vector<std::string>& paths);
+
+    /// Delete the events replaced by LoadEventPaths().  This is called after
+    /// the handlers have redrawn the current event.
+    void DeleteReplacedEvents();
+
+    /// Check if the current event already contains the folders for the
+    /// paths, so LoadEventPaths() won't replace it.
+    bool IsLoaded(const std::vector<std::string>& paths);
+
+    /// Mark that the current event is being used without the event lock
+    /// (e.g. by the handler builds of an update).  While the event is held,
+    /// GetEvent() and LoadEventPaths() must not be called, since they can
+    /// replace (and delete) the current event.  They log an error and leave
+    /// the event alone if they are.  Each HoldEvent() must be matched by a
+    /// ReleaseEvent().
+    void HoldEvent();
+
+    /// Release a hold taken by HoldEvent().
+    void ReleaseEvent();
+
+    /// Read an entry from a random access source and remove it from the
+    /// event folder.  This returns NULL if the entry can't be read.  The
+    /// caller must hold the event lock.
+    static CP::TEvent* ReadSourceEntry(CP::TVInputFile* source, int entry);
+
+    /// Get the number of entries in a random access source (or zero if it
+    /// isn't random access).  The caller must hold the event lock.
+    static int GetSourceEntryCount(CP::TVInputFile* source);
+
+    /// Reread the number of entries committed to a file that is still being
+    /// written (without reopening the file).  This returns the new number of
+    /// entries.  Only a single CP::TRootInput file can be refreshed.  The
+    /// caller must hold the event lock.
+    static int RefreshSource(CP::TVInputFile* source);
+
+    /// Check the input source for entries that have been added since the
+    /// file was opened (see RefreshSource()).  This returns the new number of
+    /// entries.
+    int Refresh();
+
+    /// Get the lock that serializes access to the input files and the event
+    /// folder.
+    static TMutex& GetEventLock();
+
+    /// Remove an event from the event folder so that it won't be returned as
+    /// the current event.  The caller must hold the event lock.
+    static void DetachEvent(CP::TEvent* event);
+
+    /// Add an event to the event folder so that it becomes the current
+    /// event.  The caller must hold the event lock.
+    static void AttachEvent(CP::TEvent* event);
+
+private:
+    /// The function run by the worker thread.
+    static void* ThreadFunction(void* arg);
+
+    /// The worker loop.  This reads entries until the prefetcher is stopped.
+    void Run();
+
+    /// The slots in the ring.  An entry is saved in slot "entry % size".
+    struct Slot {
+        Slot(): entry(-1), event(NULL), bytes(0) {}
+        int entry;
+        CP::TEvent* event;
+        /// The estimated memory used by the event.
+        Long64_t bytes;
+        /// The folders that were removed from the event.
+        std::vector<std::string> pruned;
+    };
+    std::vector<Slot> fRing;
+
+    /// Read an entry from the input source into result, and remove the
+    /// large folders that aren't in the needed paths.  This takes the event
+    /// lock and returns a detached event (or NULL on failure).
+    CP::TEvent* ReadEntry(int entry,
+                          const std::vector<std::string>& needed,
+                          Slot& result);
+
+    /// Check if an event with the pruned folders has all of the folders
+    /// needed for the paths.
+    static bool HasPaths(const std::vector<std::string>& pruned,
+                         const std::vector<std::string>& paths);
+
+    /// Check if an entry is inside of the ring around the current entry.
+    /// This must be called while holding fLock.
+    bool InWindow(int entry) const;
+
+    /// Find the next entry that the worker should read, or -1 if the ring is
+    /// full.  Entries following the current entry are read first.  This must
+    /// be called while holding fLock.
+    int NextEntryToRead() const;
+
+    /// Save an event that has been read in the ring, and take ownership of
+    /// it.  If the entry has moved out of the ring, the event is put in the
+    /// cache, and if it isn't wanted, it's added to doomed.  This must be
+    /// called while holding fLock.
+    void Store(Slot& result, std::vector<CP::TEvent*>& doomed);
+
+    /// Move the event in a slot to the cache and empty the slot.  The events
+    /// that need to be deleted are added to doomed.  This must be called
+    /// while holding fLock.
+    void Retire(Slot& slot, std::vector<CP::TEvent*>& doomed);
+
+    /// Move an entry from the cache into the ring.  This returns false if
+    /// the entry isn't in the cache (or is missing a needed folder).  This
+    /// must be called while holding fLock.
+    bool TakeFromCache(int entry, std::vector<CP::TEvent*>& doomed);
+
+    /// Delete events while holding the event lock.  This must not be called
+    /// while holding fLock.
+    static void DeleteEvents(std::vector<CP::TEvent*>& events);
+
+    /// The input source of events.
+    CP::TVInputFile* fEventSource;
+
+    /// The number of events in the input source.
+    int fEntryCount;
+
+    /// The number of entries after the current entry to keep.
+    int fNextCount;
+
+    /// The number of entries before the current entry to keep.
+    int fPreviousCount;
+
+    /// The entry currently being shown.
+    int fCurrentEntry;
+
+    /// The entry being read by the worker thread (or -1).
+    int fReadingEntry;
+
+    /// The event that has been attached to the event folder.  This is only
+    /// changed by the GUI thread while holding the event lock.
+    CP::TEvent* fAttachedEvent;
+
+    /// The number of holds on the current event (see HoldEvent()).
+    int fHolds;
+
+    /// The events replaced by LoadEventPaths() that haven't been deleted.
+    std::vector<CP::TEvent*> fReplaced;
+
+    /// The event paths needed by the display.
+    std::vector<std::string> fEventPaths;
+
+    /// The large folders that can be removed from an event.
+    std::vector<std::string> fLazyFolders;
+
+    /// The cache of events that have dropped out of the ring (or NULL if
+    /// the cache is disabled).
+    CP::TEventCache* fCache;
+
+    /// The number of requested events that were found in memory.
+    int fHitCount;
+
+    /// The number of requested events that had to be read.
+    int fMissCount;
+
+    /// A flag that the worker thread is indexing the input files (see
+    /// CP::TEventChain::IndexStep()) when it has nothing else to read.
+    bool fIndexing;
+
+    /// A flag to tell the worker thread to stop.
+    bool fStop;
+
+    /// The lock protecting the ring and the entry numbers.
+    TMutex fLock;
+
+    /// Signal the worker that the current entry has changed.
+    TCondition fWakeUp;
+
+    /// Signal waiting readers that the worker has finished an entry.
+    TCondition fReady;
+
+    /// The worker thread.
+    TThread* fThread;
+};
+#endif
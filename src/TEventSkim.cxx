@@ -0,0 +1,294 @@
+#include "TEventSkim.hxx"
+#include "TVSkimPredicate.hxx"
+#include "TEventPrefetch.hxx"
+
+#include <TCaptLog.hxx>
+#include <TEvent.hxx>
+#include <THandle.hxx>
+#include <THitSelection.hxx>
+#include <TReconBase.hxx>
+#include <TReconTrack.hxx>
+#include <TReconNode.hxx>
+#include <TTrackState.hxx>
+#include <TVInputFile.hxx>
+
+#include <TThread.h>
+#include <TVirtualMutex.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+    /// Select events with at least (or more than) a number of drift hits.
+    class TSkimDriftHits: public CP::TVSkimPredicate {
+    public:
+        TSkimDriftHits(double cut, bool inclusive)
+            : fCut(cut), fInclusive(inclusive) {}
+        bool Select(CP::TEvent& event) const {
+            CP::THandle<CP::THitSelection> hits
+                = event.Get<CP::THitSelection>("~/hits/drift");
+            if (!hits) return false;
+            double value = hits->size();
+            return fInclusive ? (value >= fCut) : (value > fCut);
+        }
+        std::string GetDescription() const {
+            std::ostringstream desc;
+            desc << "hits " << (fInclusive ? ">=" : ">") << " " << fCut;
+            return desc.str();
+        }
+    private:
+        double fCut;
+        bool fInclusive;
+    };
+
+    /// Select events with a TReconTrack longer than a length.  The length is
+    /// the sum of the distances between the track nodes, and every
+    /// reconstruction container in the event is checked.
+    class TSkimTrackLength: public CP::TVSkimPredicate {
+    public:
+        TSkimTrackLength(double cut, bool inclusive)
+            : fCut(cut), fInclusive(inclusive) {}
+        bool Select(CP::TEvent& event) const {
+            std::vector<CP::TDatum*> stack;
+            stack.push_back(&event);
+            while (!stack.empty()) {
+                CP::TDatum* current = stack.back();
+                stack.pop_back();
+                CP::TReconObjectContainer* rc
+                    = dynamic_cast<CP::TReconObjectContainer*>(current);
+                if (rc) {
+                    for (CP::TReconObjectContainer::iterator o = rc->begin();
+                         o != rc->end(); ++o) {
+                        CP::THandle<CP::TReconTrack> track = *o;
+                        if (!track) continue;
+                        double value = TrackLength(track);
+                        if (fInclusive ? (value >= fCut) : (value > fCut)) {
+                            return true;
+                        }
+                    }
+                    continue;
+                }
+                CP::TDataVector* dv = dynamic_cast<CP::TDataVector*>(current);
+                if (dv) {
+                    for (CP::TDataVector::iterator d = dv->begin();
+                         d != dv->end(); ++d) {
+                        stack.push_back(*d);
+                    }
+                }
+            }
+            return false;
+        }
+        std::string GetDescription() const {
+            std::ostringstream desc;
+            desc << "track " << (fInclusive ? ">=" : ">") << " " << fCut;
+            return desc.str();
+        }
+    private:
+        double TrackLength(CP::THandle<CP::TReconTrack> track) const {
+            double length = 0.0;
+            TVector3 last;
+            bool first = true;
+            for (CP::TReconNodeContainer::iterator n
+                     = track->GetNodes().begin();
+                 n != track->GetNodes().end(); ++n) {
+                CP::THandle<CP::TTrackState> state = (*n)->GetState();
+                if (!state) continue;
+                TVector3 pos = state->GetPosition().Vect();
+                if (!first) length += (pos-last).Mag();
+                last = pos;
+                first = false;
+            }
+            return length;
+        }
+        double fCut;
+        bool fInclusive;
+    };
+
+    /// Select events where the total PMT charge is above a value.
+    class TSkimPMTCharge: public CP::TVSkimPredicate {
+    public:
+        TSkimPMTCharge(double cut, bool inclusive)
+            : fCut(cut), fInclusive(inclusive) {}
+        bool Select(CP::TEvent& event) const {
+            CP::THandle<CP::THitSelection> hits
+                = event.Get<CP::THitSelection>("~/hits/pmt");
+            if (!hits) return false;
+            double value = 0.0;
+            for (CP::THitSelection::iterator h = hits->begin();
+                 h != hits->end(); ++h) {
+                value += (*h)->GetCharge();
+            }
+            return fInclusive ? (value >= fCut) : (value > fCut);
+        }
+        std::string GetDescription() const {
+            std::ostringstream desc;
+            desc << "pmt " << (fInclusive ? ">=" : ">") << " " << fCut;
+            return desc.str();
+        }
+    private:
+        double fCut;
+        bool fInclusive;
+    };
+};
+
+CP::TEventSkim::TEventSkim(CP::TVInputFile* source,
+                           CP::TVSkimPredicate* predicate,
+                           int threads)
+    : fEventSource(source), fPredicate(predicate), fEntryCount(0),
+      fNextEntry(0), fScanned(0), fStop(false),
+      fThreadCount(std::max(1,threads)), fRunning(0), fLock(kTRUE) {
+    {
+        TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
+        fEntryCount = CP::TEventPrefetch::GetSourceEntryCount(fEventSource);
+    }
+
+    CaptLog("Skim " << fEntryCount << " entries for "
+            << fPredicate->GetDescription());
+    TThread::Initialize();
+    TLockGuard guard(&fLock);
+    StartThreads();
+}
+
+CP::TEventSkim::~TEventSkim() {
+    fLock.Lock();
+    fStop = true;
+    fLock.UnLock();
+    JoinThreads();
+    delete fPredicate;
+}
+
+void CP::TEventSkim::StartThreads() {
+    for (int i = 0; i < fThreadCount; ++i) {
+        TThread* thread = new TThread("eventSkim",
+                                      &CP::TEventSkim::ThreadFunction,
+                                      this);
+        fThreads.push_back(thread);
+        ++fRunning;
+        thread->Run();
+    }
+}
+
+void CP::TEventSkim::JoinThreads() {
+    for (std::vector<TThread*>::iterator t = fThreads.begin();
+         t != fThreads.end(); ++t) {
+        (*t)->Join();
+        delete (*t);
+    }
+    fThreads.clear();
+}
+
+void CP::TEventSkim::AddEntries(int entries) {
+    TLockGuard guard(&fLock);
+    if (fStop || entries <= fEntryCount) return;
+    CaptLog("Skim " << entries - fEntryCount << " new entries");
+    fEntryCount = entries;
+    if (fRunning > 0) return;
+    // The old workers have left Run(), so joining them doesn't wait for the
+    // lock held here.
+    JoinThreads();
+    StartThreads();
+}
+
+CP::TVSkimPredicate* CP::TEventSkim::MakePredicate(
+    const std::string& expression) {
+    std::size_t sep = expression.find(">");
+    if (sep == std::string::npos) return NULL;
+    bool inclusive = (expression.substr(sep,2) == ">=");
+
+    std::string name;
+    std::istringstream nameStream(expression.substr(0,sep));
+    if (!(nameStream >> name)) return NULL;
+
+    double cut;
+    std::istringstream cutStream(expression.substr(sep + (inclusive ? 2 : 1)));
+    if (!(cutStream >> cut)) return NULL;
+
+    if (name == "hits") return new TSkimDriftHits(cut,inclusive);
+    if (name == "track") return new TSkimTrackLength(cut,inclusive);
+    if (name == "pmt") return new TSkimPMTCharge(cut,inclusive);
+    return NULL;
+}
+
+int CP::TEventSkim::FindMatch(int entry, int step) {
+    TLockGuard guard(&fLock);
+    if (step == 0) return entry;
+    int index;
+    if (step > 0) {
+        std::vector<int>::iterator next
+            = std::upper_bound(fMatches.begin(), fMatches.end(), entry);
+        index = (next - fMatches.begin()) + step - 1;
+    }
+    else {
+        std::vector<int>::iterator previous
+            = std::lower_bound(fMatches.begin(), fMatches.end(), entry);
+        index = (previous - fMatches.begin()) + step;
+    }
+    if (index < 0 || index >= (int) fMatches.size()) return -1;
+    return fMatches[index];
+}
+
+int CP::TEventSkim::GetMatchCount() {
+    TLockGuard guard(&fLock);
+    return fMatches.size();
+}
+
+int CP::TEventSkim::GetScannedCount() {
+    TLockGuard guard(&fLock);
+    return fScanned;
+}
+
+bool CP::TEventSkim::IsComplete() {
+    TLockGuard guard(&fLock);
+    return (fScanned >= fEntryCount);
+}
+
+std::string CP::TEventSkim::GetDescription() const {
+    return fPredicate->GetDescription();
+}
+
+void* CP::TEventSkim::ThreadFunction(void* arg) {
+    CP::TEventSkim* skim = static_cast<CP::TEventSkim*>(arg);
+    skim->Run();
+    return NULL;
+}
+
+void CP::TEventSkim::Run() {
+    while (true) {
+        int entry;
+        {
+            TLockGuard guard(&fLock);
+            if (fStop || fNextEntry >= fEntryCount) {
+                --fRunning;
+                return;
+            }
+            entry = fNextEntry++;
+        }
+
+        CP::TEvent* event = NULL;
+        {
+            TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
+            event = CP::TEventPrefetch::ReadSourceEntry(fEventSource, entry);
+        }
+
+        // The event isn't in the event folder, so this thread is the only
+        // one looking at it.
+        bool selected = event && fPredicate->Select(*event);
+
+        if (event) {
+            TLockGuard guard(&CP::TEventPrefetch::GetEventLock());
+            delete event;
+        }
+
+        TLockGuard guard(&fLock);
+        ++fScanned;
+        if (selected) {
+            fMatches.insert(std::upper_bound(fMatches.begin(),
+                                             fMatches.end(), entry),
+                            entry);
+        }
+        if (fScanned == fEntryCount) {
+            CaptLog("Finished skim with " << fMatches.size()
+                    << " matching entries");
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef TEventSkim_hxx_seen
+#define TEventSkim_hxx_seen
+
+#include <TMutex.h>
+#include <TVirtualMutex.h>
+
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TEventSkim;
+    class TVSkimPredicate;
+    class TVInputFile;
+};
+
+class TThread;
+
+/// Scan a random access event source in the background and keep a sorted
+/// list of the entries that pass a selection (a CP::TVSkimPredicate).  The
+/// list fills in progressively while the scan runs, so the display can step
+/// through the matching entries as soon as they are found.  This is used by
+/// CP::TEventChangeManager so that the Next/Previous buttons skip the
+/// entries that don't pass the selection.
+///
+/// The entries are read one at a time while holding the
+/// CP::TEventPrefetch::GetEventLock() lock, so the display and the prefetch
+/// can interleave with the scan.  The events are decoded into the
+/// CP::TEventFolder by the input file, and ROOT I/O isn't thread safe, so
+/// the reading isn't parallel.  Only the selection is applied after the lock
+/// is released, so more than one worker thread only helps when the
+/// selection is slow compared to reading an entry (the default is one, see
+/// the "eventDisplay.skim.threads" parameter).
+class CP::TEventSkim {
+public:
+    /// Start scanning the source using "threads" worker threads.  The source
+    /// must be random access (see CP::TEventPrefetch::IsRandomAccess()).
+    /// The skim takes ownership of the predicate, but not of the source.
+    TEventSkim(CP::TVInputFile* source, CP::TVSkimPredicate* predicate,
+               int threads);
+    ~TEventSkim();
+
+    /// Make one of the built in predicates from an expression.  The
+    /// expression has the form "<name> >= <value>" (or ">") where the name
+    /// is one of
+    ///
+    /// - hits  : The number of drift hits in "~/hits/drift".
+    /// - track : The length (in mm) of the longest TReconTrack.
+    /// - pmt   : The total charge of the hits in "~/hits/pmt".
+    ///
+    /// This returns NULL if the expression can't be parsed.
+    static CP::TVSkimPredicate* MakePredicate(const std::string& expression);
+
+    /// Find the entry that is "step" matching entries after (or before if
+    /// step is negative) the entry.  The entry itself doesn't need to match.
+    /// This returns -1 if there isn't a matching entry (yet).
+    int FindMatch(int entry, int step);
+
+    /// Get the number of entries that have passed the selection so far.
+    int GetMatchCount();
+
+    /// Get the number of entries that have been scanned so far.
+    int GetScannedCount();
+
+    /// Get the number of entries in the event source.
+    int GetEntryCount() {
+        TLockGuard guard(&fLock);
+        return fEntryCount;
+    }
+
+    /// Scan the entries that have been added to the event source since the
+    /// skim started (e.g. while following a file that is being written).
+    /// The source has "entries" entries, and it must not have changed the
+    /// entries that are already scanned.
+    void AddEntries(int entries);
+
+    /// Check if all of the entries have been scanned.
+    bool IsComplete();
+
+    /// Get the description of the selection.
+    std::string GetDescription() const;
+
+private:
+    /// The function run by the worker threads.
+    static void* ThreadFunction(void* arg);
+
+    /// The worker loop.  This scans entries until the source is finished or
+    /// the skim is stopped.
+    void Run();
+
+    /// Start the worker threads.  This must be called with fLock held.
+    void StartThreads();
+
+    /// Wait for the worker threads to finish, and delete them.
+    void JoinThreads();
+
+    /// The input source of events.
+    CP::TVInputFile* fEventSource;
+
+    /// The selection to apply.
+    CP::TVSkimPredicate* fPredicate;
+
+    /// The number of entries in the input source.
+    int fEntryCount;
+
+    /// The next entry to be claimed by a worker.
+    int fNextEntry;
+
+    /// The number of entries that have been scanned.
+    int fScanned;
+
+    /// The sorted entries that passed the selection.
+    std::vector<int> fMatches;
+
+    /// A flag to tell the worker threads to stop.
+    bool fStop;
+
+    /// The number of worker threads to start.
+    int fThreadCount;
+
+    /// The number of worker threads that are still scanning.  The workers
+    /// stop when they run out of entries, so AddEntries() has to start new
+    /// ones when this is zero.
+    int fRunning;
+
+    /// The lock protecting the entry counters and the matches.
+    TMutex fLock;
+
+    /// The worker threads.
+    std::vector<TThread*> fThreads;
+};
+#endif
@@ -0,0 +1,251 @@
+#include "TEventSummary.hxx"
+#include "TEventDisplay.hxx"
+#include "THandleCache.hxx"
+
+#include <CaptGeomId.hxx>
+#include <TEvent.hxx>
+#include <TEventFolder.hxx>
+#include <THitSelection.hxx>
+#include <TDigit.hxx>
+#include <TPulseDigit.hxx>
+#include <TCalibPulseDigit.hxx>
+#include <HEPUnits.hxx>
+
+#include <TChannelInfo.hxx>
+#include <TChannelCalib.hxx>
+
+#include <algorithm>
+#include <cmath>
+
+CP::TEventSummary::Hits::Hits()
+    : minTime(1E+22), maxTime(-1E+22),
+      minCharge(1E+22), maxCharge(-1E+22),
+      wireTimeStep(-1.0) {}
+
+CP::TEventSummary::Digits::Digits()
+    : sampleCount(0), sampleStep(-1.0), triggerOffset(0.0),
+      wireTimeStep(-1.0), lowSample(0.0), medianSample(0.0),
+      highSample(0.0), signalStart(1E+6), signalEnd(-1E+6) {}
+
+CP::TEventSummary::TEventSummary()
+    : fEvent(NULL), fDriftHitsFilled(false), fPMTHitsFilled(false) {}
+
+CP::TEventSummary::~TEventSummary() {}
+
+void CP::TEventSummary::Reset() {
+    fEvent = NULL;
+    fDriftHitsFilled = false;
+    fPMTHitsFilled = false;
+    fDriftHits = Hits();
+    for (int i = 0; i < 3; ++i) fPlaneHits[i] = Hits();
+    fPMTHits = Hits();
+    fDigits.clear();
+}
+
+void CP::TEventSummary::CheckEvent() {
+    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
+    if (event == fEvent) return;
+    Reset();
+    fEvent = event;
+}
+
+const CP::TEventSummary::Hits& CP::TEventSummary::GetDriftHits(int plane) {
+    CheckEvent();
+    if (!fDriftHitsFilled) {
+        FillHits("~/hits/drift", fDriftHits, fPlaneHits);
+        fDriftHitsFilled = true;
+    }
+    if (plane < 0 || plane > 2) return fDriftHits;
+    return fPlaneHits[plane];
+}
+
+const CP::TEventSummary::Hits& CP::TEventSummary::GetPMTHits() {
+    CheckEvent();
+    if (!fPMTHitsFilled) {
+        FillHits("~/hits/pmt", fPMTHits, NULL);
+        fPMTHitsFilled = true;
+    }
+    return fPMTHits;
+}
+
+const CP::TEventSummary::Digits& CP::TEventSummary::GetDigits(
+    const std::string& path, int plane) {
+    CheckEvent();
+    std::pair<std::string,int> key(path,plane);
+    std::map<std::pair<std::string,int>, Digits>::iterator found
+        = fDigits.find(key);
+    if (found != fDigits.end()) return found->second;
+    Digits& digits = fDigits[key];
+    FillDigits(path, plane, digits);
+    return digits;
+}
+
+void CP::TEventSummary::FillHits(const char* path, Hits& all,
+                                 Hits* planes) {
+    if (!fEvent) return;
+    CP::THandle<CP::THitSelection> hits
+        = CP::TEventDisplay::Get().Handles().Get<CP::THitSelection>(
+            *fEvent, path);
+    if (!hits) return;
+
+    CP::TChannelCalib chanCalib;
+    for (CP::THitSelection::iterator h = hits->begin();
+         h != hits->end(); ++h) {
+        Hits* targets[2] = {&all, NULL};
+        if (planes) {
+            int plane = CP::GeomId::Captain::GetWirePlane((*h)->GetGeomId());
+            if (0 <= plane && plane < 3) targets[1] = &planes[plane];
+        }
+        for (int i = 0; i < 2; ++i) {
+            Hits* target = targets[i];
+            if (!target) continue;
+            target->hits.push_back(*h);
+            target->minTime = std::min(target->minTime, (*h)->GetTime());
+            target->maxTime = std::max(target->maxTime, (*h)->GetTime());
+            target->minCharge = std::min(target->minCharge,
+                                         (*h)->GetCharge());
+            target->maxCharge = std::max(target->maxCharge,
+                                         (*h)->GetCharge());
+            if (target->wireTimeStep < 0.0) {
+                target->wireTimeStep
+                    = chanCalib.GetTimeConstant((*h)->GetChannelId(),1);
+            }
+        }
+    }
+}
+
+void CP::TEventSummary::FillDigits(const std::string& path, int plane,
+                                   Digits& digits) {
+    if (!fEvent) return;
+    digits.container
+        = CP::TEventDisplay::Get().Handles().Get<CP::TDigitContainer>(
+            *fEvent, path);
+    if (!digits.container) return;
+
+    CP::TChannelCalib chanCalib;
+    std::vector<double> samples;
+    for (CP::TDigitContainer::const_iterator d = digits.container->begin();
+         d != digits.container->end(); ++d) {
+        // Figure out if this is in the right plane, and get the wire
+        // number.
+        const CP::TDigit* digit = dynamic_cast<const CP::TDigit*>(*d);
+        if (!digit) continue;
+        CP::TGeometryId id
+            = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
+        if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
+        digits.digits.push_back(digit);
+        digits.wires.push_back(CP::GeomId::Captain::GetWireNumber(id));
+        // Save the sample to find the quantiles.
+        for (std::size_t i = 0; i < GetDigitSampleCount(digit); ++i) {
+            double s = GetDigitSample(digit,i);
+            if (!std::isfinite(s)) continue;
+            samples.push_back(s);
+        }
+        if (digits.sampleStep < 0) {
+            digits.sampleStep = GetDigitSampleStep(digit);
+            digits.triggerOffset = GetDigitTriggerOffset(digit);
+        }
+        if (digits.wireTimeStep < 0.0) {
+            digits.wireTimeStep
+                = chanCalib.GetTimeConstant(digit->GetChannelId(),1);
+        }
+    }
+
+    // It shouldn't be possible to have digits without any samples, but...
+    digits.sampleCount = samples.size();
+    if (samples.empty()) return;
+
+    // Only the quantiles are needed, so the samples don't need to be fully
+    // sorted.
+    std::size_t n = samples.size();
+    std::nth_element(samples.begin(), samples.begin() + std::size_t(0.5*n),
+                     samples.end());
+    digits.medianSample = samples[0.5*n];
+    std::nth_element(samples.begin(), samples.begin() + std::size_t(0.01*n),
+                     samples.end());
+    digits.lowSample = samples[0.01*n];
+    std::nth_element(samples.begin(), samples.begin() + std::size_t(0.99*n),
+                     samples.end());
+    digits.highSample = samples[0.99*n];
+
+    double maxSample = std::abs(digits.highSample - digits.medianSample);
+    maxSample = std::max(maxSample,
+                         std::abs(digits.lowSample - digits.medianSample));
+
+    // Find the time range based on the times of the digits with a signal.
+    // In most files, the result will be the full range of the digitizer
+    // 0-9595, or the full range of the calibrated times (-1600 usec to 3197
+    // usec), but things get a little more complicated for the MC.
+    std::vector<double> times;
+    for (std::vector<const CP::TDigit*>::iterator d = digits.digits.begin();
+         d != digits.digits.end(); ++d) {
+        double maxSignal = 0.0;
+        for (std::size_t i = 0; i < GetDigitSampleCount(*d); ++i) {
+            double s = std::abs(GetDigitSample(*d,i) - digits.medianSample);
+            if (!std::isfinite(s)) continue;
+            if (maxSignal < s) maxSignal = s;
+        }
+        if (maxSignal < 0.25*maxSample) continue;
+        times.push_back(GetDigitFirstTime(*d));
+        times.push_back(GetDigitLastTime(*d));
+    }
+    if (times.empty()) return;
+    std::sort(times.begin(),times.end());
+    digits.signalStart = times[0.01*times.size()];
+    digits.signalEnd = times[0.99*times.size()];
+}
+
+double CP::TEventSummary::GetDigitFirstTime(const CP::TDigit* d) {
+    const CP::TPulseDigit* pulse
+        = dynamic_cast<const CP::TPulseDigit*>(d);
+    if (pulse) return pulse->GetFirstSample();
+    const CP::TCalibPulseDigit* calib
+        = dynamic_cast<const CP::TCalibPulseDigit*>(d);
+    if (calib) return calib->GetFirstSample()/unit::microsecond;
+    return 0.0;
+}
+
+double CP::TEventSummary::GetDigitLastTime(const CP::TDigit* d) {
+    const CP::TPulseDigit* pulse
+        = dynamic_cast<const CP::TPulseDigit*>(d);
+    if (pulse) return pulse->GetFirstSample()+pulse->GetSampleCount();
+    const CP::TCalibPulseDigit* calib
+        = dynamic_cast<const CP::TCalibPulseDigit*>(d);
+    if (calib) return calib->GetLastSample()/unit::microsecond;
+    return 0.0;
+}
+
+std::size_t CP::TEventSummary::GetDigitSampleCount(const CP::TDigit* d) {
+    const CP::TPulseDigit* pulse
+        = dynamic_cast<const CP::TPulseDigit*>(d);
+    if (pulse) return pulse->GetSampleCount();
+    const CP::TCalibPulseDigit* calib
+        = dynamic_cast<const CP::TCalibPulseDigit*>(d);
+    if (calib) return calib->GetSampleCount();
+    return 0;
+}
+
+double CP::TEventSummary::GetDigitTriggerOffset(const CP::TDigit* d) {
+    const CP::TPulseDigit* pulse
+        = dynamic_cast<const CP::TPulseDigit*>(d);
+    if (!pulse) return 0.0;
+    CP::TChannelCalib chanCalib;
+    double off = chanCalib.GetTimeConstant(pulse->GetChannelId(),0);
+    double tim = chanCalib.GetTimeConstant(pulse->GetChannelId(),1);
+    return - off/tim;
+}
+
+double CP::TEventSummary::GetDigitSampleStep(const CP::TDigit* d) {
+    double diff = GetDigitLastTime(d) - GetDigitFirstTime(d);
+    return diff/GetDigitSampleCount(d);
+}
+
+double CP::TEventSummary::GetDigitSample(const CP::TDigit* d, int i) {
+    const CP::TPulseDigit* pulse
+        = dynamic_cast<const CP::TPulseDigit*>(d);
+    if (pulse) return pulse->GetSample(i);
+    const CP::TCalibPulseDigit* calib
+        = dynamic_cast<const CP::TCalibPulseDigit*>(d);
+    if (calib) return calib->GetSample(i);
+    return 0;
+}
@@ -0,0 +1,161 @@
+#ifndef TEventSummary_hxx_seen
+#define TEventSummary_hxx_seen
+
+#include <THandle.hxx>
+#include <THit.hxx>
+#include <TDigitContainer.hxx>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace CP {
+    class TEventSummary;
+    class TEvent;
+    class TDigit;
+};
+
+/// Values derived from the hits and digits of the current event that are
+/// needed by more than one plot.  The plots (e.g. CP::TPlotDigitsHits,
+/// CP::TPlotTimeCharge, and CP::TPlotHitSamples) used to scan the drift hits
+/// and digits every time a button was pressed.  The summary sorts the hits
+/// and digits by wire plane, and finds the time and charge ranges, and the
+/// sample quantiles the first time they are needed, so the later plots for
+/// the same event start immediately.
+///
+/// The summary is owned by CP::TEventDisplay and is accessed through
+/// CP::TEventDisplay::Summary().  It is reset by
+/// CP::TEventChangeManager::NewEvent(), and it is rebuilt when the current
+/// event is replaced (e.g. after more folders are read).  It must only be
+/// used on the main thread.
+class CP::TEventSummary {
+public:
+    /// The hits of one type (in one wire plane).
+    struct Hits {
+        Hits();
+
+        /// The hits in the order of the hit selection.
+        std::vector< CP::THandle<CP::THit> > hits;
+
+        /// The time range of the hits.
+        double minTime;
+        double maxTime;
+
+        /// The charge range of the hits.
+        double minCharge;
+        double maxCharge;
+
+        /// The time per digitizer sample for the channel of the first hit.
+        /// This is negative if there aren't any hits.
+        double wireTimeStep;
+    };
+
+    /// The digits in one wire plane for one digit container.
+    struct Digits {
+        Digits();
+
+        /// The container.  This is NULL if it's not in the event.
+        CP::THandle<CP::TDigitContainer> container;
+
+        /// The digits in the plane.
+        std::vector<const CP::TDigit*> digits;
+
+        /// The wire number for each digit.
+        std::vector<int> wires;
+
+        /// The number of finite samples in the plane.
+        int sampleCount;
+
+        /// The sample step (see GetDigitSampleStep()) for the first digit.
+        double sampleStep;
+
+        /// The trigger offset (see GetDigitTriggerOffset()) for the first
+        /// digit.
+        double triggerOffset;
+
+        /// The time per digitizer sample for the channel of the first digit.
+        double wireTimeStep;
+
+        /// The 1%, 50% and 99% quantiles of the sample values.
+        double lowSample;
+        double medianSample;
+        double highSample;
+
+        /// The range of sample times that have a signal.  This is the 1% to
+        /// 99% range of the times of the digits with a sample far from the
+        /// median.
+        double signalStart;
+        double signalEnd;
+    };
+
+    TEventSummary();
+    ~TEventSummary();
+
+    /// Forget the summary of the last event.
+    void Reset();
+
+    /// Get the "~/hits/drift" hits in a wire plane (0 is x, 1 is v, 2 is u),
+    /// or all of the drift hits if the plane is negative.
+    const Hits& GetDriftHits(int plane = -1);
+
+    /// Get the "~/hits/pmt" hits.
+    const Hits& GetPMTHits();
+
+    /// Get the digits in a wire plane for a digit container (e.g.
+    /// "~/digits/drift").
+    const Digits& GetDigits(const std::string& path, int plane);
+
+    /// Get the time of the first sample of a digit.  This is the sample
+    /// number for raw digits, and the time in microseconds for calibrated
+    /// digits.
+    static double GetDigitFirstTime(const CP::TDigit* d);
+
+    /// Get the time after the last sample of a digit.
+    static double GetDigitLastTime(const CP::TDigit* d);
+
+    /// Get the number of samples in a digit.
+    static std::size_t GetDigitSampleCount(const CP::TDigit* d);
+
+    /// Get the sample number of the trigger.  This will be 3200 for raw
+    /// digits and 0 for calibrated digits.
+    static double GetDigitTriggerOffset(const CP::TDigit* d);
+
+    /// Get the step between samples.  This will be 1 for raw digits and
+    /// 500ns for calibrated digits.
+    static double GetDigitSampleStep(const CP::TDigit* d);
+
+    /// Get a sample value.
+    static double GetDigitSample(const CP::TDigit* d, int i);
+
+private:
+    /// Reset the summary if the current event has changed.
+    void CheckEvent();
+
+    /// Summarize a hit selection.  If planes isn't NULL, the hits are also
+    /// sorted into the three wire planes.
+    void FillHits(const char* path, Hits& all, Hits* planes);
+
+    /// Sort a digit container by wire plane, and find the sample ranges.
+    void FillDigits(const std::string& path, int plane, Digits& digits);
+
+    /// The event that was summarized.
+    CP::TEvent* fEvent;
+
+    /// Flags that the hits have been summarized.
+    bool fDriftHitsFilled;
+    bool fPMTHitsFilled;
+
+    /// All of the drift hits.
+    Hits fDriftHits;
+
+    /// The drift hits in each wire plane.
+    Hits fPlaneHits[3];
+
+    /// The PMT hits.
+    Hits fPMTHits;
+
+    /// The digits for each container path and plane.
+    std::map<std::pair<std::string,int>, Digits> fDigits;
+};
+#endif
@@ -24,6 +24,11 @@ CP::TFindResultsHandler::TFindResultsHandler() {
 CP::TFindResultsHandler::~TFindResultsHandler() {
 }
 
+void CP::TFindResultsHandler::AddEventPaths(
+    std::vector<std::string>& paths) {
+    paths.push_back("~/fits");
+}
+
 void CP::TFindResultsHandler::Apply() {
     CaptError("Find the results");
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
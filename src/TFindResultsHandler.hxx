@@ -17,10 +17,16 @@ class CP::TFindResultsHandler: public TVEventChangeHandler {
 public:
     TFindResultsHandler();
     ~TFindResultsHandler();
+
+    /// The name used for the timing.
+    virtual const char* GetName() const {return "TFindResultsHandler";}
     
     /// Draw fit information into the current scene.
     virtual void Apply();
 
+    /// Add the event paths read by Apply().
+    virtual void AddEventPaths(std::vector<std::string>& paths);
+
 };
 
 #endif
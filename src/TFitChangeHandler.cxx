@@ -1,11 +1,13 @@
 #include "TFitChangeHandler.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEvePool.hxx"
 #include "TShowDriftHits.hxx"
 #include "TMatrixElement.hxx"
 #include "TReconTrackElement.hxx"
 #include "TReconShowerElement.hxx"
 #include "TReconClusterElement.hxx"
+#include "TFrameBudget.hxx"
 
 #include <TCaptLog.hxx>
 #include <TEvent.hxx>
@@ -26,6 +28,7 @@
 #include <TGButton.h>
 #include <TGListBox.h>
 #include <TCollection.h>
+#include <TVirtualMutex.h>
 
 #include <TEveManager.h>
 #include <TEveGeoShape.h>
@@ -47,43 +50,59 @@ CP::TFitChangeHandler::TFitChangeHandler() {
     gEve->AddElement(fFitList);
     fShowFitsHits = true;
     fShowFitsObjects = true;
+    fShowUncertainty = true;
+    fHitBoxes = true;
 }
 
 CP::TFitChangeHandler::~TFitChangeHandler() {
 }
 
-void CP::TFitChangeHandler::Apply() {
-
-    fHitList->DestroyElements();
-    fFitList->DestroyElements();
-    fCameraWeight = 0.0;
-    
-    if (!CP::TEventDisplay::Get().GUI().GetShowFitsButton()->IsOn()
-        && !CP::TEventDisplay::Get().GUI().GetShowFitsHitsButton()->IsOn()) {
-        CaptLog("Fits display disabled");
-        return;
-    }
+void CP::TFitChangeHandler::AddEventPaths(std::vector<std::string>& paths) {
+    paths.push_back("~/fits");
+    paths.push_back("~/hits");
+}
 
-    if (CP::TEventDisplay::Get().GUI().GetShowFitsHitsButton()->IsOn()) {
-        CaptLog("Showing Fit Hits");
-        fShowFitsHits = true;
-    }
-    else {
-        fShowFitsHits = false;
-    }
+void CP::TFitChangeHandler::Prepare() {
+    CP::TGUIManager& gui = CP::TEventDisplay::Get().GUI();
+    fShowFitsHits = gui.GetShowFitsHitsButton()->IsOn();
+    fShowFitsObjects = gui.GetShowFitsButton()->IsOn();
+    fShowClusterUncertainty = gui.GetShowClusterUncertaintyButton()->IsOn();
+    fShowClusterHits = gui.GetShowClusterHitsButton()->IsOn();
+    fShowConstituentClusters = gui.GetShowConstituentClustersButton()->IsOn();
+    fShowFitsDirection = gui.GetShowFitsDirectionButton()->IsOn();
+    fRecalculateView = gui.GetRecalculateViewButton()->IsOn();
+    fShowUncertainty = CP::TEventDisplay::Get().Budget().GetShowUncertainty();
+    fHitBoxes = CP::TEventDisplay::Get().Budget().GetHitBoxes();
+
+    fSelectedResults.clear();
+    fDrawings = Drawings();
+
+    if (!fShowFitsHits && !fShowFitsObjects) return;
+    GetSelectedResults(fSelectedResults);
+}
 
-    if (CP::TEventDisplay::Get().GUI().GetShowFitsButton()->IsOn()) {
-        CaptLog("Showing Fit Objecs");
-        fShowFitsObjects = true;
+bool CP::TFitChangeHandler::AddInputs(std::ostream& inputs) {
+    CP::TGUIManager& gui = CP::TEventDisplay::Get().GUI();
+    inputs << gui.GetShowFitsHitsButton()->IsOn()
+           << gui.GetShowFitsButton()->IsOn()
+           << gui.GetShowClusterUncertaintyButton()->IsOn()
+           << gui.GetShowClusterHitsButton()->IsOn()
+           << gui.GetShowConstituentClustersButton()->IsOn()
+           << gui.GetShowFitsDirectionButton()->IsOn()
+           << gui.GetRecalculateViewButton()->IsOn()
+           << CP::TEventDisplay::Get().Budget().GetShowUncertainty()
+           << CP::TEventDisplay::Get().Budget().GetHitBoxes();
+    std::vector<std::string> names;
+    GetSelectedResults(names);
+    for (std::vector<std::string>::iterator n = names.begin();
+         n != names.end(); ++n) {
+        inputs << " " << *n;
     }
-    else {
-        fShowFitsObjects = false;
-    }
-
-    CaptLog("Handle the fit information");
-    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
-    if (!event) return;
+    return true;
+}
 
+void CP::TFitChangeHandler::GetSelectedResults(
+    std::vector<std::string>& names) {
     // Get a TList of all of the selected entries.
     TList selected;
     CP::TEventDisplay::Get().GUI().GetResultsList()
@@ -92,29 +111,143 @@ void CP::TFitChangeHandler::Apply() {
     // Iterate through the list of selected entries.
     TIter next(&selected);
     TGLBEntry* lbEntry;
-    int index = 0;
     while ((lbEntry = (TGLBEntry*) next())) {
-        std::string objName(lbEntry->GetTitle());
+        names.push_back(lbEntry->GetTitle());
+    }
+}
+
+void CP::TFitChangeHandler::Build(CP::TEvent& event) {
+    if (!fShowFitsHits && !fShowFitsObjects) return;
+
+    // Find the drawings for each of the selected fit results in order.
+    // The fit results share objects and hits (e.g. the constituents of a
+    // vertex), and the THandle reference counts aren't atomic, so the
+    // results are walked one after the other on this thread instead of
+    // being split into subtasks.  Nothing is logged here since the log
+    // isn't thread safe; messages are saved and printed by Commit().
+    for (std::vector<std::string>::iterator name = fSelectedResults.begin();
+         name != fSelectedResults.end(); ++name) {
+        if (IsCancelled()) break;
         CP::THandle<CP::TReconObjectContainer> objects 
-            = event->Get<CP::TReconObjectContainer>(objName.c_str());
-        index = ShowReconObjects(fFitList,objects,index);
+            = event.Get<CP::TReconObjectContainer>(name->c_str());
+        ShowReconObjects(fDrawings, kFitList, objects);
     }
+}
+
+void CP::TFitChangeHandler::Commit() {
 
-    if (fCameraWeight > 1 
-        && CP::TEventDisplay::Get().GUI().GetRecalculateViewButton()->IsOn()) {
+    {
+        // Deleting a TEveGeoShape changes gGeoManager (see
+        // CP::TShapeFactory), so the old elements are removed while holding
+        // the geometry lock.
+        TLockGuard guard(&GetGeometryLock());
+        CP::TEventDisplay::Get().Pool().Release(fHitList);
+        CP::TEventDisplay::Get().Pool().Release(fFitList);
+    }
+    
+    if (!fShowFitsObjects && !fShowFitsHits) {
+        CaptLog("Fits display disabled");
+        return;
+    }
+
+    if (fShowFitsHits) CaptLog("Showing Fit Hits");
+    if (fShowFitsObjects) CaptLog("Showing Fit Objecs");
+
+    CaptLog("Handle the fit information");
+    for (std::vector<std::string>::iterator m = fDrawings.errors.begin();
+         m != fDrawings.errors.end(); ++m) {
+        CaptError(*m);
+    }
+    for (std::vector<std::string>::iterator m = fDrawings.messages.begin();
+         m != fDrawings.messages.end(); ++m) {
+        CaptLog(*m);
+    }
+
+    // The elements made for each drawing so that the constituents can be
+    // added to them.
+    std::vector<TEveElementList*> elements(fDrawings.drawings.size(), NULL);
+    for (std::size_t i = 0; i < fDrawings.drawings.size(); ++i) {
+        const Drawing& drawing = fDrawings.drawings[i];
+        TEveElementList* parent = NULL;
+        if (drawing.parent == kFitList) parent = fFitList;
+        else if (drawing.parent == kHitList) parent = fHitList;
+        else parent = elements[drawing.parent];
+        if (!parent) continue;
+
+        switch (drawing.type) {
+        case Drawing::kCluster: {
+            CP::THandle<CP::TReconCluster> cluster = drawing.object;
+            elements[i] = new CP::TReconClusterElement(
+                *cluster, drawing.forceUncertainty);
+            break;
+        }
+        case Drawing::kShower: {
+            CP::THandle<CP::TReconShower> shower = drawing.object;
+            elements[i] = new CP::TReconShowerElement(*shower,true);
+            break;
+        }
+        case Drawing::kTrack: {
+            CP::THandle<CP::TReconTrack> track = drawing.object;
+            elements[i] = new CP::TReconTrackElement(
+                *track, true, fShowFitsDirection);
+            break;
+        }
+        case Drawing::kHits: {
+            CP::TShowDriftHits showDrift(1.6*unit::mm/unit::microsecond,
+                                         fHitBoxes);
+            showDrift(parent, *drawing.hits, drawing.t0);
+            break;
+        }
+        }
+        if (elements[i]) parent->AddElement(elements[i]);
+    }
+
+    if (fDrawings.cameraWeight > 1 && fRecalculateView) {
         TGLViewer* glViewer = gEve->GetDefaultGLViewer();
-        fCameraCenter *= 1.0/fCameraWeight;
+        TVector3 center
+            = (1.0/fDrawings.cameraWeight)*fDrawings.cameraCenter;
         glViewer->SetDrawCameraCenter(kTRUE);
         glViewer->CurrentCamera().SetExternalCenter(kTRUE);
-        glViewer->CurrentCamera().SetCenterVecWarp(fCameraCenter.X(),
-                                                   fCameraCenter.Y(),
-                                                   fCameraCenter.Z());
+        glViewer->CurrentCamera().SetCenterVecWarp(center.X(),
+                                                   center.Y(),
+                                                   center.Z());
     }
 
 }
 
+int CP::TFitChangeHandler::AddDrawing(
+    Drawings& result,
+    Drawing::Type type, int parent,
+    const CP::THandle<CP::TReconBase> object,
+    bool forceUncertainty) {
+    Drawing drawing;
+    drawing.type = type;
+    drawing.object = object;
+    drawing.t0 = 0.0;
+    drawing.forceUncertainty = forceUncertainty;
+    drawing.parent = parent;
+    result.drawings.push_back(drawing);
+    return result.drawings.size() - 1;
+}
+
+void CP::TFitChangeHandler::AddHitsDrawing(
+    Drawings& result,
+    int parent,
+    const CP::THandle<CP::THitSelection> hits,
+    double t0) {
+    if (!hits) return;
+    Drawing drawing;
+    drawing.type = Drawing::kHits;
+    drawing.hits = hits;
+    drawing.t0 = t0;
+    drawing.forceUncertainty = false;
+    drawing.parent = parent;
+    result.drawings.push_back(drawing);
+}
+
 int CP::TFitChangeHandler::ShowReconCluster(
-    TEveElementList* list,
+    Drawings& result,
+    int parent,
     CP::THandle<CP::TReconCluster> obj,
     int index,
     bool forceUncertainty) {
@@ -122,93 +255,81 @@ int CP::TFitChangeHandler::ShowReconCluster(
 
     CP::THandle<CP::TClusterState> state = obj->GetState();
     if (!state) {
-        CaptError("TClusterState missing!");
+        result.errors.push_back("TClusterState missing!");
         return index;
     }
 
     // Increment the index to get a new value for the names.
     ++index;
 
-    if (CP::TEventDisplay::Get().GUI()
-        .GetShowClusterUncertaintyButton()->IsOn()) {
-        forceUncertainty = true;
-    }
-
-    CP::TReconClusterElement *eveCluster
-        = new CP::TReconClusterElement(*obj,forceUncertainty);
+    if (fShowClusterUncertainty) forceUncertainty = true;
+    if (!fShowUncertainty) forceUncertainty = false;
 
-    list->AddElement(eveCluster);
+    int eveCluster = AddDrawing(result, Drawing::kCluster, parent, obj,
+                                forceUncertainty);
     
-    if (CP::TEventDisplay::Get().GUI()
-        .GetShowClusterHitsButton()->IsOn()) {
+    if (fShowClusterHits) {
         // Draw the hits.
-        CP::TShowDriftHits showDrift;
-        showDrift(eveCluster, *(obj->GetHits()), obj->GetPosition().T());
+        AddHitsDrawing(result, eveCluster,
+                       obj->GetHits(), obj->GetPosition().T());
     }
 
     return index;
 }
 
 int CP::TFitChangeHandler::ShowReconShower(
-    TEveElementList* list,
+    Drawings& result,
+    int parent,
     CP::THandle<CP::TReconShower> obj,
     int index) {
     if (!obj) return index;
 
     CP::THandle<CP::TShowerState> state = obj->GetState();
     if (!state) {
-        CaptError("TShowerState missing!");
+        result.errors.push_back("TShowerState missing!");
         return index;
     }
 
     // Get a new index
     ++index;
 
-    CP::TReconShowerElement *eveShower = new CP::TReconShowerElement(*obj,true);
-
-    list->AddElement(eveShower);
+    int eveShower = AddDrawing(result, Drawing::kShower, parent, obj, true);
 
     // Draw the clusters.
-    if (CP::TEventDisplay::Get().GUI()
-        .GetShowConstituentClustersButton()->IsOn()) {
+    if (fShowConstituentClusters) {
         for (CP::TReconNodeContainer::iterator n = obj->GetNodes().begin();
              n != obj->GetNodes().end(); ++n) {
-            index = ShowReconObject(eveShower,(*n)->GetObject(),index, false);
+            index = ShowReconObject(result, eveShower,
+                                    (*n)->GetObject(),index, false);
         }
     }
 
-    CP::TCaptLog::DecreaseIndentation();
-
     return index;
 }
 
 int CP::TFitChangeHandler::ShowReconTrack(
-    TEveElementList* list,
+    Drawings& result,
+    int parent,
     CP::THandle<CP::TReconTrack> obj,
     int index) {
     if (!obj) return index;
     CP::THandle<CP::TTrackState> frontState = obj->GetState();
     if (!frontState) {
-        CaptError("TTrackState missing!");
+        result.errors.push_back("TTrackState missing!");
         return index;
     }
 
     // Get a new index
     ++index;
 
-    TReconTrackElement *eveTrack
-        = new TReconTrackElement(
-            *obj, true,
-            (CP::TEventDisplay::Get().GUI().GetShowFitsDirectionButton()
-             ->IsOn()));
-    list->AddElement(eveTrack);
+    int eveTrack = AddDrawing(result, Drawing::kTrack, parent, obj, true);
 
     // Draw the clusters.
-    if (CP::TEventDisplay::Get().GUI()
-        .GetShowConstituentClustersButton()->IsOn()) {
+    if (fShowConstituentClusters) {
         for (CP::TReconNodeContainer::iterator n = obj->GetNodes().begin();
              n != obj->GetNodes().end(); ++n) {
-            index = ShowReconObject(eveTrack,(*n)->GetObject(),index, false);
+            index = ShowReconObject(result, eveTrack,
+                                    (*n)->GetObject(),index, false);
         }
     }
 
@@ -216,23 +337,25 @@ int CP::TFitChangeHandler::ShowReconTrack(
 }
 
 int CP::TFitChangeHandler::ShowReconPID(
-    TEveElementList* list,
+    Drawings& result,
+    int parent,
     CP::THandle<CP::TReconPID> obj, 
     int index) {
     if (!obj) return index;
-    CaptError("ShowReconPID not Implemented");
+    result.errors.push_back("ShowReconPID not Implemented");
     return index;
 }
 
 int CP::TFitChangeHandler::ShowReconVertex(
-    TEveElementList* list,
+    Drawings& result,
+    int parent,
     CP::THandle<CP::TReconVertex> obj,
     int index) {
     if (!obj) return index;
 
     CP::THandle<CP::TVertexState> state = obj->GetState();
     if (!state) {
-        CaptError("TVertexState missing!");
+        result.errors.push_back("TVertexState missing!");
         return index;
     }
     TLorentzVector pos = state->GetPosition();
@@ -240,26 +363,27 @@ int CP::TFitChangeHandler::ShowReconVertex(
 
     ++index;
 
-    CaptLog("Vertex(" << obj->GetUniqueID() << ") @ " 
+    std::ostringstream message;
+    message << "Vertex(" << obj->GetUniqueID() << ") @ " 
             << unit::AsString(pos.X(),std::sqrt(var.X()),"length")
             <<", "<<unit::AsString(pos.Y(),std::sqrt(var.Y()),"length")
-            <<", "<<unit::AsString(pos.Z(),std::sqrt(var.Z()),"length"));
+            <<", "<<unit::AsString(pos.Z(),std::sqrt(var.Z()),"length");
     
     CP::THandle<CP::TReconObjectContainer> 
         constituents = obj->GetConstituents();
     if (constituents) {
-        CP::TCaptLog::IncreaseIndentation();
-        CaptLog("Constituent objects: " << constituents->size());
-        CP::TCaptLog::IncreaseIndentation();
-        index = ShowReconObjects(list,constituents,index);
-        CP::TCaptLog::DecreaseIndentation();
-        CP::TCaptLog::DecreaseIndentation();
+        message << " with " << constituents->size()
+                << " constituent objects";
+        result.messages.push_back(message.str());
+        index = ShowReconObjects(result, parent,constituents,index);
     }
+    else result.messages.push_back(message.str());
 
     return index;
 }
 
-int CP::TFitChangeHandler::ShowReconObject(TEveElementList* list,
+int CP::TFitChangeHandler::ShowReconObject(Drawings& result,
+                                           int parent,
                                            CP::THandle<CP::TReconBase> obj,
                                            int index,
                                            bool forceUncertainty) {
@@ -269,56 +393,58 @@ int CP::TFitChangeHandler::ShowReconObject(TEveElementList* list,
     if (hits) {
         for (CP::THitSelection::iterator h = hits->begin();
              h != hits->end(); ++h) {
-            fCameraCenter += (*h)->GetCharge()*(*h)->GetPosition();
-            fCameraWeight += (*h)->GetCharge();
+            result.cameraCenter += (*h)->GetCharge()*(*h)->GetPosition();
+            result.cameraWeight += (*h)->GetCharge();
         }
     }
     CP::THandle<CP::TReconVertex> vertex = obj;
     if (vertex) {
-        index = ShowReconVertex(list, vertex, index);
+        index = ShowReconVertex(result, parent, vertex, index);
         return index;
     }
     if (!fShowFitsObjects) return index;
     CP::THandle<CP::TReconCluster> cluster = obj;
     if (cluster) {
         index = ShowReconCluster(
-            list, cluster, index, forceUncertainty);
+            result, parent, cluster, index, forceUncertainty);
         return index;
     }
     CP::THandle<CP::TReconShower> shower = obj;
     if (shower) {
-        index = ShowReconShower(list, shower, index);
+        index = ShowReconShower(result, parent, shower, index);
         return index;
     }
     CP::THandle<CP::TReconTrack> track = obj;
     if (track) {
-        index = ShowReconTrack(list, track, index);
+        index = ShowReconTrack(result, parent, track, index);
         return index;
     }
     CP::THandle<CP::TReconPID> pid = obj;
     if (pid) {
-        index = ShowReconPID(list, pid, index);
+        index = ShowReconPID(result, parent, pid, index);
         return index;
     }
     return index;
 }
 
 int CP::TFitChangeHandler::ShowReconObjects(
-    TEveElementList* list,
+    Drawings& result,
+    int parent,
     CP::THandle<CP::TReconObjectContainer> objects,
     int index) {
     if (!objects) return index;
-    CaptLog("Show " << objects->size() << " objects in " << objects->GetName());
-    CP::TCaptLog::IncreaseIndentation();
+    std::ostringstream message;
+    message << "Show " << objects->size() << " objects in "
+            << objects->GetName();
+    result.messages.push_back(message.str());
     for (CP::TReconObjectContainer::iterator obj = objects->begin();
          obj != objects->end(); ++obj) {
-        index = ShowReconObject(list,*obj, index, false);
+        if (IsCancelled()) break;
+        index = ShowReconObject(result, parent,*obj, index, false);
         if (fShowFitsHits) {
             // Draw the hits.
-            CP::TShowDriftHits showDrift;
-            showDrift(fHitList, *((*obj)->GetHits()),0.0);
+            AddHitsDrawing(result, kHitList, (*obj)->GetHits(), 0.0);
         }
     }
-    CP::TCaptLog::DecreaseIndentation();
     return index;
 }
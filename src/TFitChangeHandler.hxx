@@ -25,49 +25,119 @@ public:
 
     TFitChangeHandler();
     ~TFitChangeHandler();
+
+    /// The name used for the timing of the build.
+    virtual const char* GetName() const {return "TFitChangeHandler";}
     
+    /// The fits are built on a worker thread.
+    virtual bool IsTwoPhase() const {return true;}
+
+    /// Copy the GUI settings (including the selected fit results).
+    virtual void Prepare();
+
+    /// Find the objects and hits to draw for the selected fit results.
+    virtual void Build(CP::TEvent& event);
+
     /// Draw fit information into the current scene.
-    virtual void Apply();
+    virtual void Commit();
+
+    /// Add the state of the fit buttons and the selected fit results.
+    virtual bool AddInputs(std::ostream& inputs);
+
+    /// Add the event paths read by Build().
+    virtual void AddEventPaths(std::vector<std::string>& paths);
 
 private:
 
-    /// A method to draw a TReconCluster.
-    int ShowReconCluster(TEveElementList* list,
+    /// Something found by Build() that will be drawn by Commit().
+    struct Drawing {
+        enum Type {kCluster, kShower, kTrack, kHits};
+        Type type;
+        /// The object to draw (for a cluster, shower or track).
+        CP::THandle<CP::TReconBase> object;
+        /// The hits to draw (for kHits).
+        CP::THandle<CP::THitSelection> hits;
+        /// The time zero used to draw the hits.
+        double t0;
+        /// Flag that the uncertainty of a cluster should be drawn.
+        bool forceUncertainty;
+        /// The drawing that this is drawn inside of, or one of kFitList or
+        /// kHitList.
+        int parent;
+    };
+
+    /// The values of Drawing::parent for the top level lists.
+    enum {kFitList = -1, kHitList = -2};
+
+    /// The drawings found for the fit results, and the contribution to the
+    /// camera center.  The log isn't thread safe, so the messages found by
+    /// Build() are saved and printed by Commit().
+    struct Drawings {
+        Drawings() : cameraWeight(0.0) {}
+        std::vector<Drawing> drawings;
+        TVector3 cameraCenter;
+        double cameraWeight;
+        std::vector<std::string> messages;
+        std::vector<std::string> errors;
+    };
+
+    /// A method to find the drawings for a TReconCluster.
+    int ShowReconCluster(Drawings& result,
+                         int parent,
                          const CP::THandle<CP::TReconCluster> obj,
                          int index,
                          bool forceUncertainty);
     
-    /// A method to draw a TReconShower.
-    int ShowReconShower(TEveElementList* list,
+    /// A method to find the drawings for a TReconShower.
+    int ShowReconShower(Drawings& result,
+                        int parent,
                         const CP::THandle<CP::TReconShower> obj,
                         int index);
 
-    /// A method to draw a TReconTrack.
-    int ShowReconTrack(TEveElementList* list,
+    /// A method to find the drawings for a TReconTrack.
+    int ShowReconTrack(Drawings& result,
+                       int parent,
                        const CP::THandle<CP::TReconTrack> obj,
                        int index);
 
-    /// A method to draw a TReconPID
-    int ShowReconPID(TEveElementList* list,
+    /// A method to find the drawings for a TReconPID
+    int ShowReconPID(Drawings& result,
+                     int parent,
                      const CP::THandle<CP::TReconPID> obj,
                      int index);
 
-    /// A method to draw a TReconVertex
-    int ShowReconVertex(TEveElementList* list,
+    /// A method to find the drawings for a TReconVertex
+    int ShowReconVertex(Drawings& result,
+                        int parent,
                         const CP::THandle<CP::TReconVertex> obj,
                         int index);
 
-    /// A method to draw a generic TReconBase
-    int ShowReconObject(TEveElementList* list,
+    /// A method to find the drawings for a generic TReconBase
+    int ShowReconObject(Drawings& result,
+                        int parent,
                         const CP::THandle<CP::TReconBase> obj,
                         int index,
                         bool forceUncertainty);
 
-    /// A method to draw a TReconObjectContainer
-    int ShowReconObjects(TEveElementList* list,
+    /// A method to find the drawings for a TReconObjectContainer
+    int ShowReconObjects(Drawings& result,
+                         int parent,
                          const CP::THandle<CP::TReconObjectContainer> obj,
                          int index = 0);
 
+    /// Get the names of the fit results selected in the GUI.
+    void GetSelectedResults(std::vector<std::string>& names);
+
+    /// Add a drawing and return its index.
+    int AddDrawing(Drawings& result, Drawing::Type type, int parent,
+                   const CP::THandle<CP::TReconBase> object,
+                   bool forceUncertainty);
+
+    /// Add a drawing of hits.
+    void AddHitsDrawing(Drawings& result, int parent,
+                        const CP::THandle<CP::THitSelection> hits,
+                        double t0);
+
     /// The reconstruction objects to draw in the event.
     TEveElementList* fFitList;
 
@@ -80,11 +150,36 @@ private:
     /// A boolean to flag if the objects associated with the fit should be
     /// shown.
     bool fShowFitsObjects;
-    
-    /// The new camera center.
-    TVector3 fCameraCenter;
 
-    /// A weight used to calculate the camera center.
-    double fCameraWeight;
+    /// A boolean to flag if the uncertainty of clusters should be drawn.
+    bool fShowClusterUncertainty;
+
+    /// A boolean to flag if the hits in clusters should be drawn.
+    bool fShowClusterHits;
+
+    /// A boolean to flag if the clusters in tracks and showers should be
+    /// drawn.
+    bool fShowConstituentClusters;
+
+    /// A boolean to flag if the track direction should be drawn.
+    bool fShowFitsDirection;
+
+    /// A boolean to flag if the camera should be centered on the fits.
+    bool fRecalculateView;
+
+    /// A boolean to flag if the cluster uncertainties can be drawn.  This is
+    /// false when the CP::TFrameBudget has reduced the level of detail.
+    bool fShowUncertainty;
+
+    /// A boolean to flag if the hits are drawn as boxes with the size of the
+    /// hit RMS.  Otherwise, they are drawn as fixed size markers.
+    bool fHitBoxes;
+
+    /// The names of the selected fit results.
+    std::vector<std::string> fSelectedResults;
+
+    /// The drawings found by Build() in the order they are drawn, and the
+    /// new camera center.
+    Drawings fDrawings;
 };
 #endif
@@ -0,0 +1,95 @@
+#include "TFrameBudget.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+CP::TFrameBudget::TFrameBudget(double target, int history)
+    : fTarget(target), fHistory(std::max(1,history)), fFullDetail(false) {}
+
+CP::TFrameBudget::~TFrameBudget() {}
+
+void CP::TFrameBudget::SetTarget(double seconds) {
+    if (seconds <= 0.0) return;
+    fTarget = seconds;
+    // The levels are chosen again from scratch for the new target.
+    for (std::map<std::string, View>::iterator v = fViews.begin();
+         v != fViews.end(); ++v) {
+        v->second.level = 0;
+        v->second.costs.clear();
+    }
+}
+
+void CP::TFrameBudget::AddCost(const std::string& view, double seconds) {
+    View& v = fViews[view];
+    v.costs.push_back(seconds);
+    while (v.costs.size() > fHistory) v.costs.pop_front();
+    if (fFullDetail) return;
+
+    double cost = GetCost(view);
+
+    // Reduce the detail as soon as the view is too slow, but only increase
+    // it when a full history shows that the finer level will fit with some
+    // room to spare.  This keeps the level from flipping on every event.
+    int level = v.level;
+    if (cost > fTarget && level < kMaxLevel) ++level;
+    else if (level > 0 && v.costs.size() >= fHistory
+             && 2.0*cost < 0.8*fTarget) --level;
+    if (level == v.level) return;
+
+    CaptLog("Draw " << view << " at detail level " << level
+            << " (" << int(1000.0*cost) << " ms for a "
+            << int(1000.0*fTarget) << " ms target)");
+    v.level = level;
+    v.costs.clear();
+}
+
+int CP::TFrameBudget::GetLevel(const std::string& view) const {
+    if (fFullDetail) return 0;
+    std::map<std::string, View>::const_iterator v = fViews.find(view);
+    if (v == fViews.end()) return 0;
+    return v->second.level;
+}
+
+double CP::TFrameBudget::GetCost(const std::string& view) const {
+    std::map<std::string, View>::const_iterator v = fViews.find(view);
+    if (v == fViews.end() || v->second.costs.empty()) return -1.0;
+    double sum = 0.0;
+    for (std::deque<double>::const_iterator c = v->second.costs.begin();
+         c != v->second.costs.end(); ++c) {
+        sum += *c;
+    }
+    return sum/v->second.costs.size();
+}
+
+int CP::TFrameBudget::GetDigitOverSampling(int overSampling) const {
+    return overSampling << GetLevel("Digits");
+}
+
+bool CP::TFrameBudget::GetShowUncertainty() const {
+    return GetLevel("Event") < 1;
+}
+
+bool CP::TFrameBudget::GetHitBoxes() const {
+    return GetLevel("Event") < 2;
+}
+
+int CP::TFrameBudget::GetG4Decimation() const {
+    return 1 << GetLevel("Event");
+}
+
+std::string CP::TFrameBudget::GetStatus() const {
+    std::ostringstream status;
+    status << "Budget " << int(1000.0*fTarget) << " ms";
+    if (fFullDetail) status << " (full detail)";
+    for (std::map<std::string, View>::const_iterator v = fViews.begin();
+         v != fViews.end(); ++v) {
+        status << (v == fViews.begin() ? ": " : ", ") << v->first;
+        double cost = GetCost(v->first);
+        if (cost >= 0.0) status << " " << int(1000.0*cost) << " ms";
+        status << " level " << GetLevel(v->first);
+    }
+    return status.str();
+}
@@ -0,0 +1,107 @@
+#ifndef TFrameBudget_hxx_seen
+#define TFrameBudget_hxx_seen
+
+#include <deque>
+#include <map>
+#include <string>
+
+namespace CP {
+    class TFrameBudget;
+};
+
+/// Choose the level of detail for each view so that drawing an event stays
+/// within a latency target (e.g. 200 ms).  The time taken to draw each view
+/// ("Event" for the 3D display and "Digits" for the digit plots) is added
+/// with AddCost() when the drawing finishes.  When the average cost of the
+/// recent events is over the target, the view is drawn with less detail,
+/// and when the next finer level is expected to fit comfortably (each level
+/// roughly halves the work), the detail is increased again.  Level 0 is full
+/// detail.  The detail can be forced to full detail, and then the costs are
+/// still collected but the level isn't changed.
+///
+/// The levels are used by
+///
+/// - The digit plots : The digit oversampling is doubled for each level
+///                     (see GetDigitOverSampling()).
+/// - The fit handler : The uncertainty ellipsoids of the clusters aren't
+///                     drawn above level 0 (see GetShowUncertainty()), and
+///                     the hits are drawn as small fixed size markers
+///                     instead of boxes above level 1 (see GetHitBoxes()).
+/// - The G4 hits     : Only one out of 2^level segments is drawn (see
+///                     GetG4Decimation()).
+///
+/// The budget is owned by CP::TEventDisplay and is accessed through
+/// CP::TEventDisplay::Budget().  It must only be used on the main thread, so
+/// the handlers copy the levels in Prepare().
+class CP::TFrameBudget {
+public:
+    /// Create a budget with a target (in seconds) that averages the cost of
+    /// the last "history" events for each view.
+    TFrameBudget(double target, int history);
+    ~TFrameBudget();
+
+    /// The coarsest level of detail.
+    enum {kMaxLevel = 3};
+
+    /// Set or get the latency target in seconds.  @{
+    void SetTarget(double seconds);
+    double GetTarget() const {return fTarget;}
+    /// @}
+
+    /// Set or get the flag to always draw with full detail.  @{
+    void SetFullDetail(bool full) {fFullDetail = full;}
+    bool GetFullDetail() const {return fFullDetail;}
+    /// @}
+
+    /// Add the time (in seconds) taken to draw a view, and choose the level
+    /// of detail for the next event.
+    void AddCost(const std::string& view, double seconds);
+
+    /// Get the level of detail for a view.  This is zero (full detail) for a
+    /// view that hasn't been drawn, or when full detail is forced.
+    int GetLevel(const std::string& view) const;
+
+    /// Get the average time to draw a view for the recent events at the
+    /// current level.  This is negative if it isn't known.
+    double GetCost(const std::string& view) const;
+
+    /// Get the digit oversampling for the digit plots given the
+    /// oversampling chosen by the GUI.
+    int GetDigitOverSampling(int overSampling) const;
+
+    /// Check if the cluster uncertainty ellipsoids should be drawn.
+    bool GetShowUncertainty() const;
+
+    /// Check if the hits should be drawn as boxes showing their size
+    /// (otherwise they are drawn as small fixed size markers).
+    bool GetHitBoxes() const;
+
+    /// Get the fraction of G4 hit segments that are drawn (one out of
+    /// every N).
+    int GetG4Decimation() const;
+
+    /// Get a one line summary of the target, the costs and the levels for
+    /// the GUI.
+    std::string GetStatus() const;
+
+private:
+    /// The recent costs and the level of a view.
+    struct View {
+        View() : level(0) {}
+        std::deque<double> costs;
+        int level;
+    };
+
+    /// The latency target in seconds.
+    double fTarget;
+
+    /// The number of events averaged for each view.
+    std::size_t fHistory;
+
+    /// The flag to force full detail.
+    bool fFullDetail;
+
+    /// The views that have been drawn.
+    std::map<std::string, View> fViews;
+};
+#endif
@@ -1,6 +1,9 @@
 #include "TG4HitChangeHandler.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEvePool.hxx"
+#include "TFrameBudget.hxx"
+#include "TGeometryVoxels.hxx"
 
 #include <TCaptLog.hxx>
 #include <TG4HitSegment.hxx>
@@ -10,8 +13,6 @@
 #include <TUnitsTable.hxx>
 #include <HEPUnits.hxx>
 #include <THandle.hxx>
-#include <TGeomIdManager.hxx>
-#include <TManager.hxx>
 #include <CaptGeomId.hxx>
 
 #include <TGButton.h>
@@ -21,7 +22,8 @@
 
 #include <sstream>
 
-CP::TG4HitChangeHandler::TG4HitChangeHandler() {
+CP::TG4HitChangeHandler::TG4HitChangeHandler()
+    : fShowG4Hits(false), fFoundG4Hits(false), fDecimation(1) {
     fG4HitList = new TEveElementList("g4HitList","Geant4 Truth Hits");
     fG4HitList->SetMainColor(kCyan);
     fG4HitList->SetMainAlpha(1.0);
@@ -31,41 +33,55 @@ CP::TG4HitChangeHandler::TG4HitChangeHandler() {
 CP::TG4HitChangeHandler::~TG4HitChangeHandler() {
 }
 
-void CP::TG4HitChangeHandler::Apply() {
+void CP::TG4HitChangeHandler::AddEventPaths(
+    std::vector<std::string>& paths) {
+    if (!CP::TEventDisplay::Get().GUI().GetShowG4HitsButton()->IsOn()) return;
+    paths.push_back("truth/g4Hits");
+    paths.push_back("truth/G4Trajectories");
+}
 
-    fG4HitList->DestroyElements();
+bool CP::TG4HitChangeHandler::AddInputs(std::ostream& inputs) {
+    inputs << CP::TEventDisplay::Get().GUI().GetShowG4HitsButton()->IsOn()
+           << " " << CP::TEventDisplay::Get().Budget().GetG4Decimation();
+    return true;
+}
 
-    if (!CP::TEventDisplay::Get().GUI().GetShowG4HitsButton()->IsOn()) {
-        CaptLog("G4 hits disabled");
-        return;
-    }
+void CP::TG4HitChangeHandler::Prepare() {
+    fShowG4Hits = CP::TEventDisplay::Get().GUI().GetShowG4HitsButton()->IsOn();
+    fDecimation = CP::TEventDisplay::Get().Budget().GetG4Decimation();
+    // Start using the voxels if they have been built for this geometry.
+    CP::TEventDisplay::Get().Voxels().Update();
+    fFoundG4Hits = false;
+    fSegments.clear();
+    fErrors.clear();
+    fWarnings.clear();
+}
 
-    CaptLog("Handle the geant4 truth hits");
-    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
-    if (!event) return;
+void CP::TG4HitChangeHandler::Build(CP::TEvent& event) {
+    if (!fShowG4Hits) return;
 
     CP::THandle<CP::TDataVector> truthHits 
-        = event->Get<CP::TDataVector>("truth/g4Hits");
-
-    if (!truthHits) {
-        CaptLog("No truth hits in event");
-        return;
-    }
+        = event.Get<CP::TDataVector>("truth/g4Hits");
+    if (!truthHits) return;
+    fFoundG4Hits = true;
 
     CP::THandle<CP::TG4TrajectoryContainer> truthTrajectories
-        = event->Get<CP::TG4TrajectoryContainer>("truth/G4Trajectories");
+        = event.Get<CP::TG4TrajectoryContainer>("truth/G4Trajectories");
 
     double minEnergy = 0.18*unit::MeV/unit::mm;
     double maxEnergy = 3.0*unit::MeV/unit::mm;
+    int segmentCount = 0;
 
     for (CP::TDataVector::iterator h = truthHits->begin();
          h != truthHits->end();
          ++h) {
+        if (IsCancelled()) return;
         CP::THandle<CP::TG4HitContainer> g4Hits =
             (*h)->Get<CP::TG4HitContainer>(".");
         if (!g4Hits) {
-            CaptError("truth/g4Hits object that is not a TG4HitContainer: "
-                       << (*h)->GetName());
+            fErrors.push_back(
+                std::string("truth/g4Hits object that is not a"
+                            " TG4HitContainer: ") + (*h)->GetName());
             continue;
         }
 
@@ -76,28 +92,29 @@ void CP::TG4HitChangeHandler::Apply() {
                 = dynamic_cast<const CP::TG4HitSegment*>((*h));
             
             if (!seg) {
-                CaptWarn("Not showing TG4Hit not castable as a TG4HitSegment.");
+                fWarnings.push_back(
+                    "Not showing TG4Hit not castable as a TG4HitSegment.");
                 continue;
             }
 
+            // Only draw some of the segments when the level of detail is
+            // reduced.
+            if ((segmentCount++ % fDecimation) != 0) continue;
+
             double energy = seg->GetEnergyDeposit();
             double length = seg->GetTrackLength();
             double dEdX = energy;
             if (length>0.01*unit::mm) dEdX /= length;
 
             TGeometryId id;
-            bool validId 
-                = CP::TManager::Get().GeomId().GetGeometryId(
-                    seg->GetStartX(),seg->GetStartY(),seg->GetStartZ(), id);
+            bool validId = CP::TEventDisplay::Get().Voxels().GetGeometryId(
+                seg->GetStartX(),seg->GetStartY(),seg->GetStartZ(), id);
 
             // If the hit is outside of drift, only plot the long ones.
             if (validId 
                 && id!=CP::GeomId::Captain::Drift() 
                 && length < 2*unit::mm) continue;
 
-            
-            TEveLine* eveHit = new TEveLine(2);
-            eveHit->SetName((*h)->GetName());
             std::ostringstream title;
             title << "G4 Hit";
             if (truthTrajectories) {
@@ -118,30 +135,65 @@ void CP::TG4HitChangeHandler::Apply() {
                   << "," <<  unit::AsString(seg->GetStartY(), "length")
                   << "," <<  unit::AsString(seg->GetStartZ(), "length") << ")";
 
-            eveHit->SetTitle(title.str().c_str());
+            fSegments.push_back(Segment());
+            Segment& segment = fSegments.back();
+            segment.name = (*h)->GetName();
+            segment.title = title.str();
 
             if (validId && id==CP::GeomId::Captain::Drift()) {
-                eveHit->SetLineColor(TEventDisplay::Get().LogColor(
-                                         dEdX,
-                                         minEnergy,
-                                         maxEnergy,
-                                         3));
+                segment.color = TEventDisplay::Get().LogColor(dEdX,
+                                                              minEnergy,
+                                                              maxEnergy,
+                                                              3);
             }
             else {
-                eveHit->SetLineColor(kCyan);
+                segment.color = kCyan;
             }
 
-            eveHit->SetPoint(0,
-                             seg->GetStartX(),
-                             seg->GetStartY(),
-                             seg->GetStartZ());
-            eveHit->SetPoint(1,
-                             seg->GetStopX(),
-                             seg->GetStopY(),
-                             seg->GetStopZ());
-            fG4HitList->AddElement(eveHit);
+            segment.start[0] = seg->GetStartX();
+            segment.start[1] = seg->GetStartY();
+            segment.start[2] = seg->GetStartZ();
+            segment.stop[0] = seg->GetStopX();
+            segment.stop[1] = seg->GetStopY();
+            segment.stop[2] = seg->GetStopZ();
         }
 
     }
 
 }
+
+void CP::TG4HitChangeHandler::Commit() {
+
+    CP::TEventDisplay::Get().Pool().Release(fG4HitList);
+
+    if (!fShowG4Hits) {
+        CaptLog("G4 hits disabled");
+        return;
+    }
+
+    CaptLog("Handle the geant4 truth hits");
+    for (std::vector<std::string>::iterator m = fErrors.begin();
+         m != fErrors.end(); ++m) {
+        CaptError(*m);
+    }
+    for (std::vector<std::string>::iterator m = fWarnings.begin();
+         m != fWarnings.end(); ++m) {
+        CaptWarn(*m);
+    }
+    if (!fFoundG4Hits) {
+        CaptLog("No truth hits in event");
+        return;
+    }
+
+    for (std::vector<Segment>::iterator s = fSegments.begin();
+         s != fSegments.end(); ++s) {
+        TEveLine* eveHit = CP::TEventDisplay::Get().Pool().Get<TEveLine>();
+        eveHit->SetName(s->name.c_str());
+        eveHit->SetTitle(s->title.c_str());
+        eveHit->SetLineColor(s->color);
+        eveHit->SetPoint(0, s->start[0], s->start[1], s->start[2]);
+        eveHit->SetPoint(1, s->stop[0], s->stop[1], s->stop[2]);
+        fG4HitList->AddElement(eveHit);
+    }
+
+}
@@ -3,6 +3,9 @@
 
 #include "TVEventChangeHandler.hxx"
 
+#include <string>
+#include <vector>
+
 namespace CP {
     class TG4HitChangeHandler;
 };
@@ -15,14 +18,59 @@ public:
     TG4HitChangeHandler();
     ~TG4HitChangeHandler();
 
-    /// Draw the trajectories into the current scene.
-   virtual void Apply();
+    /// The name used for the timing of the build.
+    virtual const char* GetName() const {return "TG4HitChangeHandler";}
+
+    /// The hits are built on a worker thread.
+    virtual bool IsTwoPhase() const {return true;}
+
+    /// Copy the GUI settings.
+    virtual void Prepare();
+
+    /// Compute the segments for the hits in the event.
+    virtual void Build(CP::TEvent& event);
+
+    /// Draw the hits into the current scene.
+    virtual void Commit();
+
+    /// Add the state of the "Show G4 Hits" button, and the decimation from
+    /// the CP::TFrameBudget.
+    virtual bool AddInputs(std::ostream& inputs);
+
+    /// Add the event paths read by Build().
+    virtual void AddEventPaths(std::vector<std::string>& paths);
 
 private:
 
+    /// The segment drawn for a hit.
+    struct Segment {
+        std::string name;
+        std::string title;
+        int color;
+        float start[3];
+        float stop[3];
+    };
+
     /// The GEANT4 hits to draw in the event.
     TEveElementList* fG4HitList;
 
+    /// A boolean to flag if the hits should be drawn.
+    bool fShowG4Hits;
+
+    /// A boolean to flag if the event has truth hits.
+    bool fFoundG4Hits;
+
+    /// Only one out of this many segments is drawn.
+    int fDecimation;
+
+    /// The segments made by Build().
+    std::vector<Segment> fSegments;
+
+    /// The errors and warnings found by Build().  The log isn't thread
+    /// safe, so they are saved and printed by Commit().
+    std::vector<std::string> fErrors;
+    std::vector<std::string> fWarnings;
+
 };
 
 #endif
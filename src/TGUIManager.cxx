@@ -6,15 +6,22 @@
 #include <TGListBox.h>
 #include <TGLabel.h>
 #include <TGTextEntry.h>
+#include <TGNumberEntry.h>
+#include <TGTab.h>
 
 #include <TEveManager.h>
 #include <TEveBrowser.h>
 
+#include <TRuntimeParameters.hxx>
+
 #include <TSystem.h>
 
 CP::TGUIManager::TGUIManager() {
     MakeResultsTab();
     MakeControlTab();
+    MakeTimingTab();
+    // Show the control tab when the display starts.
+    gEve->GetBrowser()->GetTabLeft()->SetTab("Control");
 }
 
 void CP::TGUIManager::MakeControlTab() {
@@ -60,6 +67,180 @@ void CP::TGUIManager::MakeControlTab() {
     hf->AddFrame(textButton, layoutHints);
     fNextEventButton = textButton;
 
+    // The buttons to jump through the file.  These read the target entry
+    // directly, so a long jump costs the same as a single step.
+    TGHorizontalFrame* jumpFrame = new TGHorizontalFrame(hf);
+    TGLayoutHints* jumpHints 
+        = new TGLayoutHints(kLHintsLeft | kLHintsTop | kLHintsExpandX,
+                            1, 1, 0, 0);
+
+    textButton = new TGTextButton(jumpFrame, "-100");
+    textButton->SetToolTipText("Go back 100 events.");
+    jumpFrame->AddFrame(textButton, jumpHints);
+    fJumpBack100Button = textButton;
+
+    textButton = new TGTextButton(jumpFrame, "-10");
+    textButton->SetToolTipText("Go back 10 events.");
+    jumpFrame->AddFrame(textButton, jumpHints);
+    fJumpBack10Button = textButton;
+
+    textButton = new TGTextButton(jumpFrame, "+10");
+    textButton->SetToolTipText("Go forward 10 events.");
+    jumpFrame->AddFrame(textButton, jumpHints);
+    fJumpForward10Button = textButton;
+
+    textButton = new TGTextButton(jumpFrame, "+100");
+    textButton->SetToolTipText("Go forward 100 events.");
+    jumpFrame->AddFrame(textButton, jumpHints);
+    fJumpForward100Button = textButton;
+
+    hf->AddFrame(jumpFrame, layoutHints);
+
+    // The widgets to go to an entry in the file.
+    TGHorizontalFrame* entryFrame = new TGHorizontalFrame(hf);
+
+    fEntryNumber = new TGNumberEntry(entryFrame, 0, 8, -1,
+                                     TGNumberFormat::kNESInteger,
+                                     TGNumberFormat::kNEANonNegative);
+    fEntryNumber->GetNumberEntry()->SetToolTipText(
+        "The entry number in the file (starting from zero).");
+    entryFrame->AddFrame(fEntryNumber, jumpHints);
+
+    textButton = new TGTextButton(entryFrame, "Go to Entry");
+    textButton->SetToolTipText("Go to the entry number in the file.");
+    entryFrame->AddFrame(textButton, jumpHints);
+    fGotoEntryButton = textButton;
+
+    hf->AddFrame(entryFrame, layoutHints);
+
+    // The widgets to go to a run and event number.  This uses the event
+    // index for the file.
+    TGHorizontalFrame* eventFrame = new TGHorizontalFrame(hf);
+
+    fEventName = new TGTextEntry(eventFrame);
+    fEventName->SetToolTipText(
+        "The run and event number to go to as \"run.event\".");
+    eventFrame->AddFrame(fEventName, jumpHints);
+
+    textButton = new TGTextButton(eventFrame, "Go to Event");
+    textButton->SetToolTipText("Go to the run and event number.");
+    eventFrame->AddFrame(textButton, jumpHints);
+    fGotoEventButton = textButton;
+
+    hf->AddFrame(eventFrame, layoutHints);
+
+    TGCheckButton* followButton = new TGCheckButton(hf,"Follow Newest Event");
+    followButton->SetToolTipText(
+        "Watch for events added to a file that is still being written\n"
+        "and show the newest one.");
+    followButton->SetTextJustify(36);
+    followButton->SetMargins(0,0,0,0);
+    followButton->SetWrapLength(-1);
+    hf->AddFrame(followButton, layoutHints);
+    fFollowButton = followButton;
+
+    // The widgets to step through the events automatically.
+    TGHorizontalFrame* autoplayFrame = new TGHorizontalFrame(hf);
+
+    TGCheckButton* autoplayButton = new TGCheckButton(autoplayFrame,
+                                                      "Autoplay (Hz)");
+    autoplayButton->SetToolTipText(
+        "Step through the events automatically at the rate given in Hz.\n"
+        "Events are skipped when drawing can't keep up.");
+    autoplayFrame->AddFrame(autoplayButton, jumpHints);
+    fAutoplayButton = autoplayButton;
+
+    fAutoplayRate = new TGNumberEntry(
+        autoplayFrame,
+        CP::TRuntimeParameters::Get().GetParameterD(
+            "eventDisplay.autoplay.rate"),
+        5, -1,
+        TGNumberFormat::kNESRealOne,
+        TGNumberFormat::kNEAPositive);
+    fAutoplayRate->GetNumberEntry()->SetToolTipText(
+        "The number of events to show each second.");
+    autoplayFrame->AddFrame(fAutoplayRate, jumpHints);
+
+    hf->AddFrame(autoplayFrame, layoutHints);
+
+    fAutoplayStatus = new TGLabel(hf, "Autoplay stopped");
+    fAutoplayStatus->SetTextJustify(kTextLeft);
+    hf->AddFrame(fAutoplayStatus, layoutHints);
+
+    // The progress of the drawing that is done in the background, and a
+    // button to stop it.
+    TGHorizontalFrame* jobFrame = new TGHorizontalFrame(hf);
+
+    textButton = new TGTextButton(jobFrame, "Stop");
+    textButton->SetToolTipText(
+        "Stop drawing the event and the plots.  The parts that\n"
+        "have already been drawn are left.");
+    jobFrame->AddFrame(textButton, jumpHints);
+    fStopJobsButton = textButton;
+
+    fJobStatus = new TGLabel(jobFrame, "Idle");
+    fJobStatus->SetTextJustify(kTextLeft);
+    jobFrame->AddFrame(fJobStatus, layoutHints);
+
+    hf->AddFrame(jobFrame, layoutHints);
+
+    // The widgets to control the level of detail.
+    TGHorizontalFrame* detailFrame = new TGHorizontalFrame(hf);
+
+    TGCheckButton* fullDetailButton = new TGCheckButton(detailFrame,
+                                                        "Full Detail");
+    fullDetailButton->SetToolTipText(
+        "Always draw with full detail.  Otherwise, the detail is\n"
+        "reduced when drawing is slower than the budget (in ms).");
+    detailFrame->AddFrame(fullDetailButton, jumpHints);
+    fFullDetailButton = fullDetailButton;
+
+    fDetailTarget = new TGNumberEntry(
+        detailFrame,
+        CP::TRuntimeParameters::Get().GetParameterD(
+            "eventDisplay.detail.target"),
+        6, -1,
+        TGNumberFormat::kNESInteger,
+        TGNumberFormat::kNEAPositive);
+    fDetailTarget->GetNumberEntry()->SetToolTipText(
+        "The time in ms allowed to draw an event.");
+    detailFrame->AddFrame(fDetailTarget, jumpHints);
+
+    hf->AddFrame(detailFrame, layoutHints);
+
+    fDetailStatus = new TGLabel(hf, "Budget");
+    fDetailStatus->SetTextJustify(kTextLeft);
+    hf->AddFrame(fDetailStatus, layoutHints);
+
+    // The widgets to skim the file.  When a skim is running, the event
+    // buttons only move through the events that pass the selection.
+    TGHorizontalFrame* skimFrame = new TGHorizontalFrame(hf);
+
+    fSkimSelection = new TGTextEntry(skimFrame);
+    fSkimSelection->SetText("hits>=100");
+    fSkimSelection->SetToolTipText(
+        "The selection for events to show.  This can be\n"
+        "    hits>=N  -- At least N drift hits\n"
+        "    track>L  -- A track longer than L mm\n"
+        "    pmt>Q    -- Total PMT charge above Q");
+    skimFrame->AddFrame(fSkimSelection, jumpHints);
+
+    textButton = new TGTextButton(skimFrame, "Skim");
+    textButton->SetToolTipText("Only show events passing the selection.");
+    skimFrame->AddFrame(textButton, jumpHints);
+    fStartSkimButton = textButton;
+
+    textButton = new TGTextButton(skimFrame, "All");
+    textButton->SetToolTipText("Stop the skim and show all events.");
+    skimFrame->AddFrame(textButton, jumpHints);
+    fStopSkimButton = textButton;
+
+    hf->AddFrame(skimFrame, layoutHints);
+
+    fSkimStatus = new TGLabel(hf, "Showing all events");
+    fSkimStatus->SetTextJustify(kTextLeft);
+    hf->AddFrame(fSkimStatus, layoutHints);
+
     // Create the buttons to select which types of objects are showed.
     TGCheckButton *checkButton;
 
@@ -151,6 +332,16 @@ void CP::TGUIManager::MakeControlTab() {
     hf->AddFrame(checkButton, layoutHints);
     fRecalculateViewButton = checkButton;
 
+    textButton = new TGTextButton(hf, "Reset Camera");
+    fResetCameraButton = textButton;
+    textButton->SetTextJustify(36);
+    textButton->SetMargins(0,0,0,0);
+    textButton->SetWrapLength(-1);
+    hf->AddFrame(textButton, layoutHints);
+    textButton->SetToolTipText(
+        "Reset the camera to show the whole detector.  The camera is "
+        "otherwise left where it is when the event changes.");
+
     /////////////////////
     // Button to draw the first hit zoomed in the digit plot.
     /////////////////////
@@ -351,4 +542,60 @@ void CP::TGUIManager::MakeResultsTab() {
     browser->SetTabTitle("Recon", 0);
 }
 
+void CP::TGUIManager::MakeTimingTab() {
+    TEveBrowser* browser = gEve->GetBrowser();
+
+    // Embed a new frame in the event browser to show the timing.
+    browser->StartEmbedding(TRootBrowser::kLeft);
+    TGMainFrame* mainFrame = new TGMainFrame(gClient->GetRoot(), 1000, 600);
+    mainFrame->SetWindowName("Timing");
+    mainFrame->SetCleanup(kDeepCleanup);
+
+    TGVerticalFrame* hf = new TGVerticalFrame(mainFrame);
+    TGLayoutHints* layoutHints = new TGLayoutHints(kLHintsLeft
+                                                   | kLHintsTop
+                                                   | kLHintsExpandX,
+                                                   2,2,2,2);
+
+    TGCheckButton* checkButton = new TGCheckButton(hf,"Collect Timing");
+    checkButton->SetToolTipText(
+        "Time reading the event, each handler, the plots and the redraw.");
+    hf->AddFrame(checkButton, layoutHints);
+    fTimingButton = checkButton;
+
+    // Create the listbox for the timing summary.
+    fTimingList = new TGListBox(hf);
+    TGLayoutHints* layoutList = new TGLayoutHints(kLHintsLeft
+                                                  | kLHintsTop
+                                                  | kLHintsExpandX 
+                                                  | kLHintsExpandY);
+    hf->AddFrame(fTimingList,layoutList);
+
+    fTimingFile = new TGTextEntry(hf);
+    fTimingFile->SetText("eventDisplay-timing.csv");
+    fTimingFile->SetToolTipText("The file to save the timing in.");
+    hf->AddFrame(fTimingFile,layoutHints);
+
+    TGTextButton* textButton = new TGTextButton(hf, "Save Timing CSV");
+    textButton->SetToolTipText(
+        "Save the timing for the recent events (one row per event\n"
+        "and timer).");
+    hf->AddFrame(textButton, layoutHints);
+    fSaveTimingButton = textButton;
+
+    // Do the final layout and mapping.
+    TGLayoutHints* layoutFrame 
+        = new TGLayoutHints(kLHintsLeft 
+                            | kLHintsTop 
+                            | kLHintsExpandX
+                            | kLHintsExpandY,
+                            2, 2, 2, 2);
+    mainFrame->AddFrame(hf, layoutFrame);
+    mainFrame->MapSubwindows();
+    mainFrame->Resize();
+    mainFrame->MapWindow();
+    browser->StopEmbedding();
+    browser->SetTabTitle("Timing", 0);
+}
+
 CP::TGUIManager::~TGUIManager() { }
@@ -4,6 +4,8 @@
 #include <TGButton.h>
 #include <TGListBox.h>
 #include <TGTextEntry.h>
+#include <TGNumberEntry.h>
+#include <TGLabel.h>
 
 namespace CP {
     class TGUIManager;
@@ -41,6 +43,74 @@ public:
     /// Get the previous event button widget.
     TGButton* GetPrevEventButton() {return fPrevEventButton;}
 
+    /// Get the buttons to jump backward by 100 and 10 events.  @{
+    TGButton* GetJumpBack100Button() {return fJumpBack100Button;}
+    TGButton* GetJumpBack10Button() {return fJumpBack10Button;}
+    /// @}
+
+    /// Get the buttons to jump forward by 10 and 100 events.  @{
+    TGButton* GetJumpForward10Button() {return fJumpForward10Button;}
+    TGButton* GetJumpForward100Button() {return fJumpForward100Button;}
+    /// @}
+
+    /// Get the number entry widget with the entry number to go to.  This is
+    /// updated to show the entry number of the current event.
+    TGNumberEntry* GetEntryNumber() {return fEntryNumber;}
+
+    /// Get the button to go to the entry in the entry number widget.
+    TGButton* GetGotoEntryButton() {return fGotoEntryButton;}
+
+    /// Get the text entry widget with the "run.event" to go to.
+    TGTextEntry* GetEventName() {return fEventName;}
+
+    /// Get the button to go to the event in the event name widget.
+    TGButton* GetGotoEventButton() {return fGotoEventButton;}
+
+    /// Get the check button selecting if the display should follow the
+    /// newest event in a file that is still being written.
+    TGButton* GetFollowButton() {return fFollowButton;}
+
+    /// Get the check button that starts stepping through the events
+    /// automatically.
+    TGButton* GetAutoplayButton() {return fAutoplayButton;}
+
+    /// Get the number entry widget with the autoplay rate in Hz.
+    TGNumberEntry* GetAutoplayRate() {return fAutoplayRate;}
+
+    /// Get the label showing the achieved autoplay rate and the number of
+    /// dropped frames.
+    TGLabel* GetAutoplayStatus() {return fAutoplayStatus;}
+
+    /// Get the button to stop the drawing that is running in the background.
+    TGButton* GetStopJobsButton() {return fStopJobsButton;}
+
+    /// Get the label showing the progress of the drawing that is running in
+    /// the background.
+    TGLabel* GetJobStatus() {return fJobStatus;}
+
+    /// Get the check button that forces the event to be drawn with full
+    /// detail.
+    TGButton* GetFullDetailButton() {return fFullDetailButton;}
+
+    /// Get the number entry widget with the time (in ms) allowed to draw an
+    /// event.
+    TGNumberEntry* GetDetailTarget() {return fDetailTarget;}
+
+    /// Get the label showing the drawing times and the levels of detail.
+    TGLabel* GetDetailStatus() {return fDetailStatus;}
+
+    /// Get the text entry widget with the skim selection (e.g. "hits>=100").
+    TGTextEntry* GetSkimSelection() {return fSkimSelection;}
+
+    /// Get the button to start a skim using the skim selection.
+    TGButton* GetStartSkimButton() {return fStartSkimButton;}
+
+    /// Get the button to stop the skim and show all events.
+    TGButton* GetStopSkimButton() {return fStopSkimButton;}
+
+    /// Get the label showing the progress of the skim.
+    TGLabel* GetSkimStatus() {return fSkimStatus;}
+
     /// Get the check button selecting if reconstruction objects are shown.
     TGButton* GetShowFitsButton() {return fShowFitsButton;}
 
@@ -73,6 +143,9 @@ public:
     /// Get the check button selecting if view point should be recalculated.
     TGButton* GetRecalculateViewButton() {return fRecalculateViewButton;}
 
+    /// Get the button to reset the camera to show the whole scene.
+    TGButton* GetResetCameraButton() {return fResetCameraButton;}
+
     /// Get the button to draw the U plane digits.
     TGButton* GetDrawTimeChargeButton() {return fDrawTimeChargeButton;}
 
@@ -126,6 +199,22 @@ public:
     /// The get text entry widget for the default result to show.
     TGTextEntry* GetDefaultResult() {return fDefaultResult;}
 
+    /////////////////////
+    // TIMING TAB WIDGETS
+    /////////////////////
+
+    /// Get the check button to collect the timing.
+    TGButton* GetTimingButton() {return fTimingButton;}
+
+    /// Get the list box showing the timing summary.
+    TGListBox* GetTimingList() {return fTimingList;}
+
+    /// Get the text entry widget with the name of the timing CSV file.
+    TGTextEntry* GetTimingFile() {return fTimingFile;}
+
+    /// Get the button to write the timing CSV file.
+    TGButton* GetSaveTimingButton() {return fSaveTimingButton;}
+
 private:
 
     /// Make a tab in the browser for control buttons.
@@ -137,6 +226,27 @@ private:
     TGButton* fNextEventButton;
     TGButton* fDrawEventButton;
     TGButton* fPrevEventButton;
+    TGButton* fJumpBack100Button;
+    TGButton* fJumpBack10Button;
+    TGButton* fJumpForward10Button;
+    TGButton* fJumpForward100Button;
+    TGNumberEntry* fEntryNumber;
+    TGButton* fGotoEntryButton;
+    TGTextEntry* fEventName;
+    TGButton* fGotoEventButton;
+    TGButton* fFollowButton;
+    TGButton* fAutoplayButton;
+    TGNumberEntry* fAutoplayRate;
+    TGLabel* fAutoplayStatus;
+    TGButton* fStopJobsButton;
+    TGLabel* fJobStatus;
+    TGButton* fFullDetailButton;
+    TGNumberEntry* fDetailTarget;
+    TGLabel* fDetailStatus;
+    TGTextEntry* fSkimSelection;
+    TGButton* fStartSkimButton;
+    TGButton* fStopSkimButton;
+    TGLabel* fSkimStatus;
     TGButton* fShowFitsHitsButton;
     TGButton* fShowFitsButton;
     TGButton* fShowFitsDirectionButton;
@@ -146,6 +256,7 @@ private:
     TGButton* fShowTrajectoriesButton;
     TGButton* fShowG4HitsButton;
     TGButton* fRecalculateViewButton;
+    TGButton* fResetCameraButton;
     TGButton* fDrawHitButton;
     TGButton* fDrawTimeChargeButton;
     TGButton* fFitTimeChargeButton;
@@ -175,5 +286,16 @@ private:
     /// A regular expression to select the default result(s) to be selected.
     TGTextEntry* fDefaultResult;
 
+    /// Make a tab in the browser to show the timing.
+    void MakeTimingTab();
+
+    ////////////////////////////////////////
+    // Widgets in the timing tab.
+    ////////////////////////////////////////
+    TGButton* fTimingButton;
+    TGListBox* fTimingList;
+    TGTextEntry* fTimingFile;
+    TGButton* fSaveTimingButton;
+
 };
 #endif
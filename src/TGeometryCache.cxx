@@ -0,0 +1,239 @@
+#include "TGeometryCache.hxx"
+#include "TVEventChangeHandler.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <TSystem.h>
+#include <TFile.h>
+#include <TMD5.h>
+#include <TCollection.h>
+#include <TGeoManager.h>
+#include <TGeoVolume.h>
+#include <TGeoNode.h>
+#include <TGeoMatrix.h>
+#include <TGeoBBox.h>
+#include <TGeoPcon.h>
+#include <TGeoPgon.h>
+#include <TGeoMedium.h>
+#include <TGeoMaterial.h>
+#include <TEveGeoShape.h>
+#include <TEveGeoShapeExtract.h>
+#include <TVirtualMutex.h>
+
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    /// The name of the extract in the cache file.  The version is part of
+    /// the hash, and must be changed when the contents of the simplified
+    /// geometry change.
+    const char* kExtractName = "simplifiedGeometry";
+    const char* kCacheVersion = "simplifiedGeometry-1";
+};
+
+CP::TGeometryCache::TGeometryCache(const std::string& directory) {
+    if (directory.empty() || directory == "none") return;
+    TString expanded(directory.c_str());
+    gSystem->ExpandPathName(expanded);
+    fDirectory = expanded.Data();
+}
+
+CP::TGeometryCache::~TGeometryCache() {}
+
+std::string CP::TGeometryCache::GetGeometryHash() {
+    if (!gGeoManager) return "";
+
+    std::ostringstream desc;
+    desc << std::setprecision(8);
+    desc << kCacheVersion
+         << " " << gGeoManager->GetName()
+         << " " << gGeoManager->GetTitle();
+
+    // Describe each volume by its shape, its material (which sets the
+    // color), and the placements of the daughters.  The logical volumes are
+    // much fewer than the physical nodes, so this is fast.
+    TIter nextVolume(gGeoManager->GetListOfVolumes());
+    TGeoVolume* volume;
+    while ((volume = dynamic_cast<TGeoVolume*>(nextVolume()))) {
+        desc << " " << volume->GetName();
+        DescribeShape(volume->GetShape(), desc);
+        TGeoMedium* medium = volume->GetMedium();
+        if (medium) {
+            desc << " " << medium->GetName();
+            TGeoMaterial* material = medium->GetMaterial();
+            if (material) {
+                desc << " " << material->GetName()
+                     << " " << material->GetDensity();
+            }
+        }
+        for (int i = 0; i < volume->GetNdaughters(); ++i) {
+            TGeoNode* node = volume->GetNode(i);
+            desc << " " << node->GetName();
+            const Double_t* trans = node->GetMatrix()->GetTranslation();
+            const Double_t* rot = node->GetMatrix()->GetRotationMatrix();
+            for (int j = 0; j < 3; ++j) desc << " " << trans[j];
+            for (int j = 0; j < 9; ++j) desc << " " << rot[j];
+        }
+    }
+
+    std::string text = desc.str();
+    TMD5 md5;
+    md5.Update(reinterpret_cast<const UChar_t*>(text.data()), text.size());
+    md5.Final();
+    return md5.AsString();
+}
+
+void CP::TGeometryCache::DescribeShape(TGeoShape* shape,
+                                       std::ostream& desc) {
+    if (!shape) return;
+    desc << " " << shape->ClassName();
+
+    // The bounding box.
+    TGeoBBox* box = dynamic_cast<TGeoBBox*>(shape);
+    if (box) {
+        const Double_t* origin = box->GetOrigin();
+        desc << " " << box->GetDX()
+             << " " << box->GetDY()
+             << " " << box->GetDZ()
+             << " " << origin[0]
+             << " " << origin[1]
+             << " " << origin[2];
+    }
+
+    // The range of each of the shape's own coordinates (e.g. the inner and
+    // outer radius, and the phi range of a tube), and the volume, catch the
+    // parameters that don't change the bounding box (e.g. cone angles).
+    // The volume of a composite shape is estimated with random points, so
+    // it isn't used.
+    for (int axis = 1; axis <= 3; ++axis) {
+        Double_t low = 0.0;
+        Double_t high = 0.0;
+        shape->GetAxisRange(axis, low, high);
+        desc << " " << low << " " << high;
+    }
+    if (!shape->IsComposite()) desc << " " << shape->Capacity();
+
+    // The sections of a polycone (or polygon).
+    TGeoPcon* pcon = dynamic_cast<TGeoPcon*>(shape);
+    if (pcon) {
+        desc << " " << pcon->GetPhi1() << " " << pcon->GetDphi();
+        for (int i = 0; i < pcon->GetNz(); ++i) {
+            desc << " " << pcon->GetZ(i)
+                 << " " << pcon->GetRmin(i)
+                 << " " << pcon->GetRmax(i);
+        }
+    }
+    TGeoPgon* pgon = dynamic_cast<TGeoPgon*>(shape);
+    if (pgon) desc << " " << pgon->GetNedges();
+}
+
+std::string CP::TGeometryCache::GetFileName(const std::string& hash) const {
+    return fDirectory + "/" + kExtractName + "-" + hash + ".root";
+}
+
+bool CP::TGeometryCache::Load(const std::string& hash, TEveElement* parent) {
+    if (!IsEnabled() || hash.empty() || !parent) return false;
+    std::string fileName = GetFileName(hash);
+
+    // AccessPathName returns true if the file can't be accessed.
+    if (gSystem->AccessPathName(fileName.c_str())) return false;
+
+    TFile* file = TFile::Open(fileName.c_str(), "READ");
+    if (!file || file->IsZombie()) {
+        CaptError("Cannot read geometry cache " << fileName);
+        delete file;
+        return false;
+    }
+
+    TEveGeoShapeExtract* extract
+        = dynamic_cast<TEveGeoShapeExtract*>(file->Get(kExtractName));
+    file->Close();
+    delete file;
+    if (!extract) {
+        CaptError("Geometry cache without a geometry " << fileName);
+        return false;
+    }
+
+    // The top level extract is the (empty) container, so only the volumes
+    // are added to the parent.  Importing the shapes changes gGeoManager
+    // (see CP::TShapeFactory), so the geometry lock is held.
+    TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+    ResetShapeCounts(extract);
+    if (extract->HasElements()) {
+        TIter next(extract->GetElements());
+        TEveGeoShapeExtract* volume;
+        while ((volume = dynamic_cast<TEveGeoShapeExtract*>(next()))) {
+            TEveGeoShape::ImportShapeExtract(volume, parent);
+        }
+    }
+    DeleteExtract(extract);
+
+    CaptLog("Read simplified geometry from " << fileName);
+    return true;
+}
+
+void CP::TGeometryCache::ResetShapeCounts(TEveGeoShapeExtract* extract) {
+    if (!extract) return;
+    // The unique id of a shape is the number of TEveGeoShape elements using
+    // it, and it was saved with the count it had when it was written.
+    if (extract->GetShape()) extract->GetShape()->SetUniqueID(0);
+    if (extract->HasElements()) {
+        TIter next(extract->GetElements());
+        TObject* child;
+        while ((child = next())) {
+            ResetShapeCounts(dynamic_cast<TEveGeoShapeExtract*>(child));
+        }
+    }
+}
+
+void CP::TGeometryCache::DeleteExtract(TEveGeoShapeExtract* extract) {
+    if (!extract) return;
+    extract->SetShape(NULL);
+    if (extract->HasElements()) {
+        TIter next(extract->GetElements());
+        TObject* child;
+        while ((child = next())) {
+            DeleteExtract(dynamic_cast<TEveGeoShapeExtract*>(child));
+        }
+        extract->GetElements()->Clear("nodelete");
+    }
+    delete extract;
+}
+
+void CP::TGeometryCache::Save(const std::string& hash,
+                              TEveGeoShape* geometry) {
+    if (!IsEnabled() || hash.empty() || !geometry) return;
+
+    if (gSystem->AccessPathName(fDirectory.c_str())
+        && gSystem->mkdir(fDirectory.c_str(), kTRUE) != 0) {
+        CaptError("Cannot create geometry cache directory " << fDirectory);
+        return;
+    }
+
+    std::string fileName = GetFileName(hash);
+    std::ostringstream tempName;
+    tempName << fileName << "." << gSystem->GetPid() << ".tmp";
+
+    TDirectory* saveDirectory = gDirectory;
+    TFile* file = TFile::Open(tempName.str().c_str(), "RECREATE");
+    if (!file || file->IsZombie()) {
+        CaptError("Cannot write geometry cache " << tempName.str());
+        delete file;
+        if (saveDirectory) saveDirectory->cd();
+        return;
+    }
+    {
+        TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+        geometry->WriteExtract(kExtractName);
+    }
+    file->Close();
+    delete file;
+    if (saveDirectory) saveDirectory->cd();
+
+    if (gSystem->Rename(tempName.str().c_str(), fileName.c_str()) != 0) {
+        CaptError("Cannot rename geometry cache " << tempName.str());
+        gSystem->Unlink(tempName.str().c_str());
+        return;
+    }
+    CaptLog("Saved simplified geometry to " << fileName);
+}
@@ -0,0 +1,80 @@
+#ifndef TGeometryCache_hxx_seen
+#define TGeometryCache_hxx_seen
+
+#include <iosfwd>
+#include <string>
+
+namespace CP {
+    class TGeometryCache;
+};
+
+class TEveElement;
+class TEveGeoShape;
+class TEveGeoShapeExtract;
+class TGeoShape;
+
+/// A cache of the simplified geometry shown by the event display (the drift
+/// region and the photosensors).  Building the simplified geometry needs a
+/// navigator lookup and a cloned shape for every volume, so it is built
+/// once, and then saved to a file in the cache directory.  The file name
+/// contains a hash of the loaded geometry, so a different geometry is never
+/// shown, and later starts read the simplified geometry directly.  The
+/// cache directory is set by the "eventDisplay.geometry.cache" parameter,
+/// and the cache is turned off when the directory is "none".
+///
+/// The simplified geometry is saved as a TEveGeoShapeExtract, which is the
+/// format Eve uses to save shape trees.  The top level shape is an empty
+/// TEveGeoShape that holds the shapes for the volumes.  Volumes that share a
+/// TGeoShape (e.g. the photosensors) are saved with a single shape, and
+/// still share it after they are read.
+class CP::TGeometryCache {
+public:
+    /// Create a cache that saves the simplified geometry in a directory.
+    explicit TGeometryCache(const std::string& directory);
+    ~TGeometryCache();
+
+    /// Get the hash of the geometry loaded in gGeoManager.  The hash is
+    /// made from the names, shapes, materials and placements of the
+    /// volumes, so it changes when anything that could be shown changes, but
+    /// it doesn't need to stream the whole geometry.  This returns an empty string if
+    /// there isn't a geometry.
+    static std::string GetGeometryHash();
+
+    /// Read the simplified geometry for a hash from the cache, and add the
+    /// shapes for the volumes to the parent.  This returns false if the
+    /// geometry hasn't been saved.
+    bool Load(const std::string& hash, TEveElement* parent);
+
+    /// Save the simplified geometry for a hash.  The file is written under
+    /// a temporary name and then renamed so that another event display
+    /// never reads a partial file.
+    void Save(const std::string& hash, TEveGeoShape* geometry);
+
+    /// Check if the cache is being used.
+    bool IsEnabled() const {return !fDirectory.empty();}
+
+private:
+    /// Add the class and the parameters of a shape to the description used
+    /// for the hash.
+    static void DescribeShape(TGeoShape* shape, std::ostream& desc);
+
+    /// Get the name of the cache file for a hash.
+    std::string GetFileName(const std::string& hash) const;
+
+    /// Clear the reference counts of the shapes in an extract before it's
+    /// imported.  TEveGeoShape counts the elements using a TGeoShape in its
+    /// unique id (see TEveGeoShape::SetShape()), and the count is streamed
+    /// with the shape, so a shape read from the file starts with the count
+    /// from when it was saved, and would never be deleted.
+    static void ResetShapeCounts(TEveGeoShapeExtract* extract);
+
+    /// Delete an extract after it has been imported.  The imported shapes
+    /// own the TGeoShape objects (see TEveGeoShape::SetShape()), so the
+    /// shapes are removed from the extract first.
+    static void DeleteExtract(TEveGeoShapeExtract* extract);
+
+    /// The directory holding the cache files.  This is empty if the cache
+    /// is turned off.
+    std::string fDirectory;
+};
+#endif
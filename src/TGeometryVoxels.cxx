@@ -0,0 +1,228 @@
+#include "TGeometryVoxels.hxx"
+#include "TVEventChangeHandler.hxx"
+#include "TEventDisplay.hxx"
+#include "TVTask.hxx"
+#include "TScopedTimer.hxx"
+
+#include <TCaptLog.hxx>
+#include <TManager.hxx>
+#include <TGeomIdManager.hxx>
+
+#include <TGeoManager.h>
+#include <TGeoMatrix.h>
+#include <TGeoVolume.h>
+#include <TGeoBBox.h>
+#include <TVirtualMutex.h>
+
+#include <algorithm>
+#include <cmath>
+
+/// Build the grid for the current geometry.
+class CP::TGeometryVoxels::BuildTask: public CP::TVTask {
+public:
+    BuildTask(double size, double margin, Grid*& result)
+        : fSize(size), fMargin(margin), fResult(result) {}
+    void Execute() {
+        fResult = CP::TGeometryVoxels::BuildGrid(fSize, fMargin, *this);
+    }
+    std::string GetName() const {return "TGeometryVoxels::BuildTask";}
+private:
+    double fSize;
+    double fMargin;
+    Grid*& fResult;
+};
+
+CP::TGeometryVoxels::TGeometryVoxels(double size, double margin)
+    : fSize(size), fMargin(margin), fGrid(NULL), fBuilt(NULL),
+      fGroup(NULL) {}
+
+CP::TGeometryVoxels::~TGeometryVoxels() {
+    StopBuild();
+    delete fGrid;
+    for (std::vector<Grid*>::iterator g = fRetired.begin();
+         g != fRetired.end(); ++g) {
+        delete (*g);
+    }
+}
+
+int CP::TGeometryVoxels::Grid::GetIdIndex(bool valid,
+                                          const CP::TGeometryId& id) {
+    if (!valid) return kNoId;
+    for (std::size_t i = kNoId+1; i < ids.size(); ++i) {
+        if (ids[i] == id) return i;
+    }
+    ids.push_back(id);
+    return ids.size() - 1;
+}
+
+void CP::TGeometryVoxels::StopBuild() {
+    if (!fGroup) return;
+    CP::TTaskPool& pool = CP::TEventDisplay::Get().Tasks();
+    pool.Cancel(*fGroup);
+    pool.Wait(*fGroup);
+    delete fGroup;
+    fGroup = NULL;
+    delete fBuilt;
+    fBuilt = NULL;
+}
+
+void CP::TGeometryVoxels::Start() {
+    StopBuild();
+
+    // A Build() that was running when the geometry changed might still be
+    // looking at the old grid, so it's kept until the next Update().
+    if (fGrid) fRetired.push_back(fGrid);
+    fGrid = NULL;
+    if (!gGeoManager || fSize <= 0.0) return;
+
+    fGroup = new CP::TTaskPool::Group;
+    CP::TEventDisplay::Get().Tasks().Submit(
+        new BuildTask(fSize, fMargin, fBuilt), *fGroup);
+}
+
+bool CP::TGeometryVoxels::Update() {
+    for (std::vector<Grid*>::iterator g = fRetired.begin();
+         g != fRetired.end(); ++g) {
+        delete (*g);
+    }
+    fRetired.clear();
+
+    if (fGroup && CP::TEventDisplay::Get().Tasks().IsDone(*fGroup)) {
+        delete fGroup;
+        fGroup = NULL;
+        fGrid = fBuilt;
+        fBuilt = NULL;
+    }
+    return fGrid != NULL;
+}
+
+CP::TGeometryVoxels::Grid* CP::TGeometryVoxels::BuildGrid(
+    double size, double margin, const CP::TVTask& task) {
+    CP::TScopedTimer timer("TGeometryVoxels::BuildGrid");
+    Grid* grid = new Grid;
+    grid->ids.push_back(CP::TGeometryId());
+
+    // Find the bounding box of the drift volume in the global frame.
+    double high[3];
+    {
+        TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+        gGeoManager->PushPath();
+        if (!CP::TManager::Get().GeomId().CdId(
+                CP::GeomId::Captain::Drift())) {
+            gGeoManager->PopPath();
+            delete grid;
+            return NULL;
+        }
+        const TGeoBBox* box = dynamic_cast<const TGeoBBox*>(
+            gGeoManager->GetCurrentVolume()->GetShape());
+        if (!box) {
+            gGeoManager->PopPath();
+            delete grid;
+            return NULL;
+        }
+        TGeoHMatrix matrix = *gGeoManager->GetCurrentMatrix();
+        gGeoManager->PopPath();
+        double half[3] = {box->GetDX(), box->GetDY(), box->GetDZ()};
+        const Double_t* origin = box->GetOrigin();
+        for (int i = 0; i < 3; ++i) {
+            grid->low[i] = 1E+30;
+            high[i] = -1E+30;
+        }
+        for (int corner = 0; corner < 8; ++corner) {
+            double local[3];
+            double master[3];
+            for (int i = 0; i < 3; ++i) {
+                local[i] = origin[i]
+                    + ((corner & (1<<i)) ? half[i]: -half[i]);
+            }
+            matrix.LocalToMaster(local, master);
+            for (int i = 0; i < 3; ++i) {
+                grid->low[i] = std::min(grid->low[i], master[i]);
+                high[i] = std::max(high[i], master[i]);
+            }
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        grid->low[i] -= margin;
+        high[i] += margin;
+        grid->count[i]
+            = std::max(1, int(std::ceil((high[i]-grid->low[i])/size)));
+    }
+
+    // Look at the center of each voxel.  The navigator safety is the
+    // distance to the nearest boundary of the volume (or any volume inside
+    // of it), so the voxel is in a single volume if the safety is larger
+    // than the distance from the center to a corner.  The geometry lock is
+    // taken for one slab of voxels at a time so that the handlers using
+    // the navigator aren't blocked for the whole build.
+    double reach = 0.5*std::sqrt(3.0)*size;
+    int boundary = 0;
+    grid->voxels.resize(grid->count[0]*grid->count[1]*grid->count[2]);
+    for (int ix = 0; ix < grid->count[0]; ++ix) {
+        if (task.IsCancelled()) {
+            delete grid;
+            return NULL;
+        }
+        TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+        gGeoManager->PushPath();
+        for (int iy = 0; iy < grid->count[1]; ++iy) {
+            for (int iz = 0; iz < grid->count[2]; ++iz) {
+                double x = grid->low[0] + (ix + 0.5)*size;
+                double y = grid->low[1] + (iy + 0.5)*size;
+                double z = grid->low[2] + (iz + 0.5)*size;
+                int voxel = (ix*grid->count[1] + iy)*grid->count[2] + iz;
+                gGeoManager->FindNode(x, y, z);
+                if (gGeoManager->Safety() < reach) {
+                    grid->voxels[voxel] = kBoundary;
+                    ++boundary;
+                    continue;
+                }
+                CP::TGeometryId id;
+                bool valid
+                    = CP::TManager::Get().GeomId().GetGeometryId(x, y, z, id);
+                grid->voxels[voxel] = grid->GetIdIndex(valid, id);
+            }
+        }
+        gGeoManager->PopPath();
+    }
+
+    CaptLog("Geometry voxels: " << grid->count[0]
+            << "x" << grid->count[1] << "x" << grid->count[2]
+            << " with " << grid->ids.size() - 1 << " volumes and "
+            << boundary << " boundary voxels");
+    return grid;
+}
+
+bool CP::TGeometryVoxels::NavigatorGeometryId(double x, double y, double z,
+                                              CP::TGeometryId& id) {
+    TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+    return CP::TManager::Get().GeomId().GetGeometryId(x, y, z, id);
+}
+
+bool CP::TGeometryVoxels::GetGeometryId(double x, double y, double z,
+                                        CP::TGeometryId& id) {
+    const Grid* grid = fGrid;
+    if (!grid) return NavigatorGeometryId(x, y, z, id);
+    // The range is checked before converting to a voxel number so that
+    // far away (or invalid) points don't overflow.
+    double fx = (x - grid->low[0])/fSize;
+    double fy = (y - grid->low[1])/fSize;
+    double fz = (z - grid->low[2])/fSize;
+    if (!(0.0 <= fx && fx < grid->count[0])
+        || !(0.0 <= fy && fy < grid->count[1])
+        || !(0.0 <= fz && fz < grid->count[2])) {
+        return NavigatorGeometryId(x, y, z, id);
+    }
+    int voxel = (int(fx)*grid->count[1] + int(fy))*grid->count[2] + int(fz);
+    int index = grid->voxels[voxel];
+    if (index == kBoundary) return NavigatorGeometryId(x, y, z, id);
+    if (index == kNoId) return false;
+    id = grid->ids[index];
+    return true;
+}
+
+bool CP::TGeometryVoxels::InDrift(double x, double y, double z) {
+    CP::TGeometryId id;
+    if (!GetGeometryId(x, y, z, id)) return false;
+    return id == CP::GeomId::Captain::Drift();
+}
@@ -0,0 +1,130 @@
+#ifndef TGeometryVoxels_hxx_seen
+#define TGeometryVoxels_hxx_seen
+
+#include "TTaskPool.hxx"
+
+#include <CaptGeomId.hxx>
+
+#include <vector>
+
+namespace CP {
+    class TGeometryVoxels;
+    class TVTask;
+};
+
+/// A grid of voxels around the drift volume that finds the geometry id for
+/// a point without using the navigator.  The handlers classify every truth
+/// hit (e.g. is it in the drift volume?), and a navigator lookup for each
+/// one needs the geometry lock, and walks the geometry tree.  The grid is
+/// built once for each geometry by looking at the center of each voxel.
+/// When the navigator safety distance at the center is larger than the
+/// voxel, the whole voxel is in the same volume, and the geometry id is
+/// saved.  Otherwise, the voxel touches a boundary, and the points in it
+/// are found with the navigator.  This means the answer is always the same
+/// as the navigator, but most points are found with a table lookup.
+///
+/// The grid covers the drift volume plus "eventDisplay.voxels.margin", and
+/// each voxel is a cube with a side of "eventDisplay.voxels.size".  Points
+/// outside of the grid use the navigator.
+///
+/// The grid is owned by CP::TEventDisplay and is accessed through
+/// CP::TEventDisplay::Voxels().  Building the grid takes about a navigator
+/// lookup per voxel, so it's built by a task in the CP::TTaskPool that is
+/// started when a new geometry is loaded (see Start()), and every point uses
+/// the navigator until it's finished.  Update() must be called on the main
+/// thread while GetGeometryId() isn't being used (e.g. in
+/// CP::TVEventChangeHandler::Prepare()) to start using a finished grid, and
+/// then GetGeometryId() can be used by the tasks in
+/// CP::TVEventChangeHandler::Build().
+class CP::TGeometryVoxels {
+public:
+    /// Create a grid with voxels of "size" that extends "margin" past the
+    /// drift volume.
+    TGeometryVoxels(double size, double margin);
+    ~TGeometryVoxels();
+
+    /// Stop using the grid for the old geometry, and start building the
+    /// grid for the geometry in gGeoManager as a task.  This is called on
+    /// the main thread when a new geometry is loaded (see
+    /// CP::TEventDisplay::GeometryChanged()).
+    void Start();
+
+    /// Start using the grid if the task started by Start() has finished.
+    /// This is called on the main thread, and returns true if the grid is
+    /// being used (otherwise every point uses the navigator).
+    bool Update();
+
+    /// Find the geometry id for a point.  This returns false if the point
+    /// isn't in a volume with a geometry id.  This is the same as
+    /// TGeomIdManager::GetGeometryId(), and it takes the geometry lock (see
+    /// CP::TVEventChangeHandler::GetGeometryLock()) when it has to use the
+    /// navigator.
+    bool GetGeometryId(double x, double y, double z, CP::TGeometryId& id);
+
+    /// Check if a point is in the drift volume.
+    bool InDrift(double x, double y, double z);
+
+private:
+    /// The voxels for one geometry.
+    struct Grid {
+        /// The low corner of the grid.
+        double low[3];
+
+        /// The number of voxels along each axis.
+        int count[3];
+
+        /// The index into ids for each voxel, or kBoundary.
+        std::vector<short> voxels;
+
+        /// The geometry ids found in the grid.  The first entry is a place
+        /// holder for kNoId.
+        std::vector<CP::TGeometryId> ids;
+
+        /// Get the index of a geometry id in ids, and add it if it's new.
+        int GetIdIndex(bool valid, const CP::TGeometryId& id);
+    };
+
+    /// The task that builds a grid.
+    class BuildTask;
+
+    /// Build the grid for the geometry in gGeoManager.  This returns NULL if
+    /// the grid can't be built (e.g. there isn't a drift volume), or the
+    /// task is cancelled.
+    static Grid* BuildGrid(double size, double margin, const CP::TVTask& task);
+
+    /// Find the geometry id with the navigator.
+    static bool NavigatorGeometryId(double x, double y, double z,
+                                    CP::TGeometryId& id);
+
+    /// Cancel the build task, and wait for it to stop.
+    void StopBuild();
+
+    /// The voxel value for a voxel that touches a boundary.
+    enum {kBoundary = -1};
+
+    /// The voxel value for a volume without a geometry id.
+    enum {kNoId = 0};
+
+    /// The side of a voxel.
+    double fSize;
+
+    /// The distance the grid extends past the drift volume.
+    double fMargin;
+
+    /// The grid being used by GetGeometryId(), or NULL if points are found
+    /// with the navigator.  This is only changed by Start() and Update().
+    Grid* fGrid;
+
+    /// The grid made by the build task.  This is only read after the task
+    /// group is done.
+    Grid* fBuilt;
+
+    /// The grids that might still be used by a Build() that was running
+    /// when the geometry changed.  They are deleted by Update().
+    std::vector<Grid*> fRetired;
+
+    /// The group of the build task, or NULL if a grid isn't being built.  A
+    /// cancelled group can't be reused, so each build has its own group.
+    CP::TTaskPool::Group* fGroup;
+};
+#endif
@@ -0,0 +1,45 @@
+#include "THandleCache.hxx"
+
+#include <TCaptLog.hxx>
+
+CP::THandleCache::THandleCache()
+    : fEvent(NULL), fEventLookups(0), fEventSaved(0),
+      fLookups(0), fSaved(0) {}
+
+CP::THandleCache::~THandleCache() {}
+
+void CP::THandleCache::Reset() {
+    Clear();
+}
+
+CP::THandle<CP::TDatum> CP::THandleCache::Find(CP::TEvent& event,
+                                               const std::string& path) {
+    if (&event != fEvent) {
+        Clear();
+        fEvent = &event;
+    }
+    ++fLookups;
+    ++fEventLookups;
+    std::map<std::string, CP::THandle<CP::TDatum> >::iterator found
+        = fHandles.find(path);
+    if (found != fHandles.end()) {
+        ++fSaved;
+        ++fEventSaved;
+        return found->second;
+    }
+    CP::THandle<CP::TDatum> handle = event.Get<CP::TDatum>(path.c_str());
+    fHandles[path] = handle;
+    return handle;
+}
+
+void CP::THandleCache::Clear() {
+    if (fEventLookups > 0) {
+        CaptInfo("Handle cache saved " << fEventSaved
+                 << " of " << fEventLookups << " lookups"
+                 << " (" << fSaved << " of " << fLookups << " total)");
+    }
+    fHandles.clear();
+    fEvent = NULL;
+    fEventLookups = 0;
+    fEventSaved = 0;
+}
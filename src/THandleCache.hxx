@@ -0,0 +1,84 @@
+#ifndef THandleCache_hxx_seen
+#define THandleCache_hxx_seen
+
+#include <TEvent.hxx>
+#include <THandle.hxx>
+
+#include <map>
+#include <string>
+
+namespace CP {
+    class THandleCache;
+};
+
+/// A cache of the handles found in the current event by name (e.g.
+/// "~/hits/drift" or "truth/G4Trajectories").  The same paths are looked up
+/// by several handlers and plots for every event, and each TEvent::Get()
+/// walks the folder tree.  The cache remembers the handle found for each
+/// path (including paths that aren't in the event), so only the first lookup
+/// in an event walks the tree.  The handles are converted to the requested
+/// type when they are returned.
+///
+/// The cache is owned by CP::TEventDisplay and is accessed through
+/// CP::TEventDisplay::Handles().  It is reset by
+/// CP::TEventChangeManager::NewEvent() and whenever it is used with a
+/// different event (e.g. after more folders are read).
+///
+/// \note The cache must only be used on the main thread (e.g. by the plots,
+/// or in CP::TVEventChangeHandler::Prepare() and Commit()).  The reference
+/// counts of a THandle aren't atomic, so copies of a cached handle must
+/// never be made or destroyed on more than one thread.  The
+/// CP::TVEventChangeHandler::Build() tasks get their objects from the event
+/// with TEvent::Get().
+///
+/// \code
+/// CP::THandle<CP::THitSelection> hits
+///     = CP::TEventDisplay::Get().Handles().Get<CP::THitSelection>(
+///           event, "~/hits/drift");
+/// \endcode
+class CP::THandleCache {
+public:
+    THandleCache();
+    ~THandleCache();
+
+    /// Get an object from the event by path.  This returns a NULL handle if
+    /// the object isn't found, or isn't the requested type.
+    template <class T>
+    CP::THandle<T> Get(CP::TEvent& event, const std::string& path) {
+        CP::THandle<T> result = Find(event, path);
+        return result;
+    }
+
+    /// Forget the handles for the last event, and report the lookups that
+    /// were saved.
+    void Reset();
+
+    /// Get the number of lookups since the cache was created.
+    int GetLookupCount() const {return fLookups;}
+
+    /// Get the number of lookups that were found in the cache (and didn't
+    /// need to walk the event) since the cache was created.
+    int GetSavedCount() const {return fSaved;}
+
+private:
+    /// Find the (untyped) handle for a path.
+    CP::THandle<CP::TDatum> Find(CP::TEvent& event, const std::string& path);
+
+    /// Forget the handles.
+    void Clear();
+
+    /// The event that the handles were found in.
+    CP::TEvent* fEvent;
+
+    /// The handles found in the event by path.
+    std::map<std::string, CP::THandle<CP::TDatum> > fHandles;
+
+    /// The number of lookups and saved lookups for the current event.
+    int fEventLookups;
+    int fEventSaved;
+
+    /// The number of lookups and saved lookups since the cache was created.
+    int fLookups;
+    int fSaved;
+};
+#endif
@@ -0,0 +1,97 @@
+#include "TLiquidVolume.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <TGeoManager.h>
+#include <TGeoNode.h>
+#include <TGeoVolume.h>
+#include <TGeoBBox.h>
+#include <TString.h>
+
+#include <algorithm>
+
+CP::TLiquidVolume::TLiquidVolume()
+    : fSerial(-1) {}
+
+CP::TLiquidVolume::~TLiquidVolume() {}
+
+bool CP::TLiquidVolume::Update(int serial) {
+    if (fSerial == serial) return IsValid();
+    fSerial = serial;
+    fVolumes.clear();
+    if (!gGeoManager || !gGeoManager->GetTopVolume()) return false;
+
+    TGeoIterator next(gGeoManager->GetTopVolume());
+    TGeoNode* node;
+    while ((node = next())) {
+        if (!TString(node->GetName()).BeginsWith("Liquid_")) continue;
+        // Everything inside of a liquid node is liquid, so the daughters
+        // don't need to be checked.
+        next.Skip();
+
+        fVolumes.push_back(Volume());
+        Volume& volume = fVolumes.back();
+        volume.matrix = *next.GetCurrentMatrix();
+        volume.shape = node->GetVolume()->GetShape();
+
+        // Find the global bounding box from the corners of the local
+        // bounding box.
+        for (int i = 0; i < 3; ++i) {
+            volume.low[i] = 1E+30;
+            volume.high[i] = -1E+30;
+        }
+        const TGeoBBox* box = dynamic_cast<const TGeoBBox*>(volume.shape);
+        if (!box) {
+            // Every geometry shape is a bounding box, but don't reject
+            // anything if that changes.
+            for (int i = 0; i < 3; ++i) {
+                volume.low[i] = -1E+30;
+                volume.high[i] = 1E+30;
+            }
+            continue;
+        }
+        double half[3] = {box->GetDX(), box->GetDY(), box->GetDZ()};
+        const Double_t* origin = box->GetOrigin();
+        for (int corner = 0; corner < 8; ++corner) {
+            double local[3];
+            double master[3];
+            for (int i = 0; i < 3; ++i) {
+                local[i] = origin[i] + ((corner & (1<<i)) ? half[i]: -half[i]);
+            }
+            volume.matrix.LocalToMaster(local, master);
+            for (int i = 0; i < 3; ++i) {
+                volume.low[i] = std::min(volume.low[i], master[i]);
+                volume.high[i] = std::max(volume.high[i], master[i]);
+            }
+        }
+    }
+
+    CaptLog("Found " << fVolumes.size() << " liquid volumes");
+    return IsValid();
+}
+
+bool CP::TLiquidVolume::Contains(const TVector3& point) const {
+    double master[3] = {point.X(), point.Y(), point.Z()};
+    for (std::vector<Volume>::const_iterator v = fVolumes.begin();
+         v != fVolumes.end(); ++v) {
+        if (master[0] < v->low[0] || v->high[0] < master[0]) continue;
+        if (master[1] < v->low[1] || v->high[1] < master[1]) continue;
+        if (master[2] < v->low[2] || v->high[2] < master[2]) continue;
+        double local[3];
+        v->matrix.MasterToLocal(master, local);
+        if (v->shape->Contains(local)) return true;
+    }
+    return false;
+}
+
+TVector3 CP::TLiquidVolume::FindBoundary(const TVector3& inside,
+                                         const TVector3& outside) const {
+    TVector3 in = inside;
+    TVector3 out = outside;
+    for (int i = 0; i < 20; ++i) {
+        TVector3 middle = 0.5*(in + out);
+        if (Contains(middle)) in = middle;
+        else out = middle;
+    }
+    return 0.5*(in + out);
+}
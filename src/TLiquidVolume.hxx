@@ -0,0 +1,73 @@
+#ifndef TLiquidVolume_hxx_seen
+#define TLiquidVolume_hxx_seen
+
+#include <TVector3.h>
+#include <TGeoMatrix.h>
+
+#include <vector>
+
+namespace CP {
+    class TLiquidVolume;
+};
+
+class TGeoShape;
+
+/// A fast test for points in the liquid argon.  The liquid is every node in
+/// the geometry with a name starting with "Liquid_" (including anything
+/// placed inside of it).  Finding the node for a point with the navigator
+/// walks the whole geometry tree and needs the geometry lock, so the liquid
+/// nodes are found once for each geometry (see
+/// CP::TEventDisplay::GetGeometrySerial()), and the global transformation,
+/// the shape, and a global bounding box are saved for each one.  A point is
+/// then tested with a bounding box check and a TGeoShape::Contains() in the
+/// local frame, which doesn't change gGeoManager, so Contains() can be used
+/// by Build() without holding the geometry lock.
+class CP::TLiquidVolume {
+public:
+    TLiquidVolume();
+    ~TLiquidVolume();
+
+    /// Find the liquid nodes if a new geometry has been loaded since the
+    /// last update.  The serial is the value of
+    /// CP::TEventDisplay::GetGeometrySerial(), which changes for each new
+    /// geometry (the gGeoManager pointer can't be used since a new geometry
+    /// can reuse the address of the old one).  This must be called on the
+    /// main thread, or while holding the geometry lock (see
+    /// CP::TVEventChangeHandler::GetGeometryLock()).  This returns false if
+    /// there isn't any liquid.
+    bool Update(int serial);
+
+    /// Check if any liquid was found by Update().
+    bool IsValid() const {return !fVolumes.empty();}
+
+    /// Check if a point is in the liquid.
+    bool Contains(const TVector3& point) const;
+
+    /// Find the point where a segment crosses the liquid boundary.  One end
+    /// must be inside, and the other outside.  The crossing is found by
+    /// bisection, so it's accurate to about a micron for steps up to about a
+    /// meter.
+    TVector3 FindBoundary(const TVector3& inside,
+                          const TVector3& outside) const;
+
+private:
+    /// A liquid node.
+    struct Volume {
+        /// The transformation from the global frame to the node.
+        TGeoHMatrix matrix;
+
+        /// The shape of the node.  This is owned by the geometry.
+        const TGeoShape* shape;
+
+        /// The bounding box of the node in the global frame.
+        double low[3];
+        double high[3];
+    };
+
+    /// The geometry serial number that the liquid was found for.
+    int fSerial;
+
+    /// The liquid nodes.
+    std::vector<Volume> fVolumes;
+};
+#endif
@@ -1,11 +1,9 @@
 #include "TMatrixElement.hxx"
+#include "TShapeFactory.hxx"
 
 #include <HEPUnits.hxx>
 #include <TCaptLog.hxx>
 
-#include <TGeoManager.h>
-#include <TGeoShape.h>
-#include <TGeoEltu.h>
 #include <TGeoMatrix.h>
 #include <TVectorD.h>
 
@@ -93,14 +91,8 @@ void CP::TMatrixElement::Initialize(const TVector3& position,
     tubeMajor = std::max(1.5*unit::mm, tubeMajor);
     tubeMinor = std::max(1.5*unit::mm, tubeMinor);
 
-    // Create the shape to display.  This has to play some fancy footsie to
-    // get the gGeoManager memory management right.  It first saves the
-    // current manager, then gets an internal geometry manager used by
-    // TEveGeoShape, and then resets the old manager once the shape is
-    // created.  You gotta love global variables...
-    TGeoManager* saveGeom = gGeoManager;
-    gGeoManager = GetGeoMangeur();
-    TGeoShape* geoShape = new TGeoEltu(tubeMajor,tubeMinor,tubeAxis);
-    SetShape(geoShape);
-    gGeoManager = saveGeom;
+    // Create the shape to display.  The factory takes care of the
+    // gGeoManager memory management (you gotta love global variables...).
+    CP::TShapeFactory::SetShape(
+        this, CP::TShapeFactory::MakeEltu(tubeMajor,tubeMinor,tubeAxis));
 }
@@ -1,6 +1,7 @@
 #include "TPMTChangeHandler.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEvePool.hxx"
 #include "TShowPMTHits.hxx"
 
 #include <TCaptLog.hxx>
@@ -44,28 +45,53 @@ CP::TPMTChangeHandler::TPMTChangeHandler() {
 
 CP::TPMTChangeHandler::~TPMTChangeHandler() {}
 
-void CP::TPMTChangeHandler::Apply() {
+void CP::TPMTChangeHandler::AddEventPaths(std::vector<std::string>& paths) {
+    paths.push_back("~/hits/pmt");
+}
 
-    fPMTList->DestroyElements();
+bool CP::TPMTChangeHandler::AddInputs(std::ostream& inputs) {
+#ifdef USE_GUI_PMTS
+    inputs << CP::TEventDisplay::Get().GUI().GetShowPMTsButton()->IsOn();
+#endif
+    return true;
+}
 
+void CP::TPMTChangeHandler::Prepare() {
+    fShowPMTsHits = true;
 #ifdef USE_GUI_PMTS
-    if (!CP::TEventDisplay::Get().GUI().GetShowPMTsButton()->IsOn()) {
-        CaptLog("PMTs display disabled");
-        return;
-    }
+    fShowPMTsHits = CP::TEventDisplay::Get().GUI().GetShowPMTsButton()->IsOn();
 #endif
+    fPMTName.clear();
+    fPMTBoxes.clear();
+}
 
-    CaptLog("Handle the PMT information");
-    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
-    if (!event) return;
+void CP::TPMTChangeHandler::Build(CP::TEvent& event) {
+    if (!fShowPMTsHits) return;
 
     CP::THandle<CP::THitSelection> pmts
-        = event->Get<CP::THitSelection>("~/hits/pmt");
+        = event.Get<CP::THitSelection>("~/hits/pmt");
     if (!pmts) return;
 
+    fPMTName = pmts->GetName();
+    CP::TShowPMTHits::MakeBoxes(*pmts, fPMTBoxes);
+}
+
+void CP::TPMTChangeHandler::Commit() {
+
+    CP::TEventDisplay::Get().Pool().Release(fPMTList);
+
+    if (!fShowPMTsHits) {
+        CaptLog("PMTs display disabled");
+        return;
+    }
+
+    if (fPMTName.empty()) return;
+
+    CaptLog("Handle the PMT information");
+
     // Draw the hits.
     CP::TShowPMTHits showPMTs(fPalette);
-    showPMTs(fPMTList, *pmts);
+    showPMTs.AddBoxes(fPMTList, fPMTName, fPMTBoxes);
 
 }
 
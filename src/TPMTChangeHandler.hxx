@@ -2,6 +2,7 @@
 #define TPMTChangeHandler_hxx_seen
 
 #include "TVEventChangeHandler.hxx"
+#include "TShowPMTHits.hxx"
 
 namespace CP {
     class TPMTChangeHandler;
@@ -16,9 +17,27 @@ public:
 
     TPMTChangeHandler();
     ~TPMTChangeHandler();
+
+    /// The name used for the timing of the build.
+    virtual const char* GetName() const {return "TPMTChangeHandler";}
     
-    /// Draw fit information into the current scene.
-    virtual void Apply();
+    /// The PMT hits are built on a worker thread.
+    virtual bool IsTwoPhase() const {return true;}
+
+    /// Clear the boxes from the last event.
+    virtual void Prepare();
+
+    /// Compute the PMT boxes for the event.
+    virtual void Build(CP::TEvent& event);
+
+    /// Draw the PMT boxes into the current scene.
+    virtual void Commit();
+
+    /// Add the state of the "Show PMTs" button (if it exists).
+    virtual bool AddInputs(std::ostream& inputs);
+
+    /// Add the event paths read by Build().
+    virtual void AddEventPaths(std::vector<std::string>& paths);
 
 private:
 
@@ -30,5 +49,11 @@ private:
 
     /// A boolean to flag if hits should be drawn.
     bool fShowPMTsHits;
+
+    /// The name of the PMT hit selection.
+    std::string fPMTName;
+
+    /// The PMT boxes made by Build().
+    std::vector<CP::TShowPMTHits::Box> fPMTBoxes;
 };
 #endif
@@ -1,25 +1,32 @@
 #include "TPlotDigitsHits.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TScopedTimer.hxx"
+#include "TEventSummary.hxx"
+#include "THandleCache.hxx"
+#include "TTaskPool.hxx"
+#include "TVTask.hxx"
+#include "TVJob.hxx"
+#include "TResultQueue.hxx"
+#include "TTimingTable.hxx"
+#include "TFrameBudget.hxx"
 
 #include <HEPUnits.hxx>
 #include <TCaptLog.hxx>
 #include <CaptGeomId.hxx>
 #include <TEvent.hxx>
 #include <TEventFolder.hxx>
-#include <TPulseDigit.hxx>
-#include <TCalibPulseDigit.hxx>
 #include <TMCChannelId.hxx>
 #include <TRuntimeParameters.hxx>
 #include <TUnitsTable.hxx>
 
-#include <TChannelInfo.hxx>
-#include <TChannelCalib.hxx>
 #include <TGeometryInfo.hxx>
 
 #include <TCanvas.h>
 #include <TPad.h>
 #include <TH2F.h>
+#include <TAxis.h>
 #include <TColor.h>
 #include <TPolyLine.h>
 #include <TMarker.h>
@@ -32,64 +39,265 @@
 #include <sstream>
 
 namespace {
-    double GetDigitFirstTime(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetFirstSample();
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetFirstSample()/unit::microsecond;
-        return 0.0;
-    }
+    /// The bins filled by a CP::TPlotDigitsHits::FillJob task.  This is
+    /// posted to the main thread to be added to the histogram.
+    class TFillResult: public CP::TVTask {
+    public:
+        TFillResult(TH2F* digitPlot, bool samplesInTime, double& maxVal)
+            : fDigitPlot(digitPlot), fSamplesInTime(samplesInTime),
+              fMaxVal(maxVal) {}
+        void Execute() {
+            for (std::vector< std::pair<int,double> >::iterator b
+                     = fBins.begin();
+                 b != fBins.end(); ++b) {
+                double val = fDigitPlot->GetBinContent(b->first);
+                if (fSamplesInTime) {
+                    fDigitPlot->SetBinContent(b->first, val+b->second);
+                }
+                else if (std::abs(b->second) > std::abs(val)) {
+                    fDigitPlot->SetBinContent(b->first, b->second);
+                }
+                fDigitPlot->SetBinError(b->first,1.0);
+                val = fDigitPlot->GetBinContent(b->first);
+                fMaxVal = std::max(fMaxVal,val);
+            }
+        }
+        std::string GetName() const {return "TPlotDigitsHits::FillResult";}
+
+        /// Check if the samples in a bin are added (otherwise the largest
+        /// sample is kept).
+        bool IsSum() const {return fSamplesInTime;}
+
+        /// The histogram bin number and the value for the bin.
+        std::vector< std::pair<int,double> > fBins;
+
+    private:
+        TH2F* fDigitPlot;
+        bool fSamplesInTime;
+        double& fMaxVal;
+    };
+
+    /// Find the histogram bins for the samples in a range of digits.  This
+    /// runs in the CP::TTaskPool, so it only uses private copies of the
+    /// histogram axes, and doesn't touch the histogram.
+    class TFillTask: public CP::TVTask {
+    public:
+        TFillTask(const std::vector<const CP::TDigit*>& digits,
+                  const std::vector<int>& wires,
+                  std::size_t begin, std::size_t end,
+                  const TAxis& xAxis, const TAxis& yAxis,
+                  double medianSample, TFillResult* result,
+                  CP::TResultQueue& results)
+            : fDigits(digits), fWires(wires), fBegin(begin), fEnd(end),
+              fXAxis(xAxis), fYAxis(yAxis), fMedianSample(medianSample),
+              fResult(result), fResults(results) {}
+        ~TFillTask() {if (fResult) delete fResult;}
+        void Execute() {
+            int rowBins = fXAxis.GetNbins() + 2;
+            for (std::size_t d = fBegin; d < fEnd; ++d) {
+                if (IsCancelled()) return;
+                const CP::TDigit* digit = fDigits[d];
+                int ix = fXAxis.FindFixBin(fWires[d] + 0.5);
+                std::size_t sampleCount
+                    = CP::TEventSummary::GetDigitSampleCount(digit);
+                double firstTime = CP::TEventSummary::GetDigitFirstTime(digit);
+                double sampleStep
+                    = CP::TEventSummary::GetDigitSampleStep(digit);
+                // Consecutive samples usually land in the same bin, so they
+                // are combined here to keep the work on the main thread
+                // small.
+                int lastBin = -1;
+                double value = 0.0;
+                for (std::size_t i = 0; i < sampleCount; ++i) {
+                    double tbin = firstTime + sampleStep*i;
+                    double sample = CP::TEventSummary::GetDigitSample(digit,i)
+                        - fMedianSample;
+                    if (!std::isfinite(sample)) continue;
+                    int bin = ix + rowBins*fYAxis.FindFixBin(tbin+1E-6);
+                    if (bin != lastBin) {
+                        if (lastBin >= 0) {
+                            fResult->fBins.push_back(
+                                std::make_pair(lastBin,value));
+                        }
+                        lastBin = bin;
+                        value = 0.0;
+                    }
+                    if (fResult->IsSum()) value += sample;
+                    else if (std::abs(sample) > std::abs(value)) {
+                        value = sample;
+                    }
+                }
+                if (lastBin >= 0) {
+                    fResult->fBins.push_back(std::make_pair(lastBin,value));
+                }
+            }
+            fResults.Post(fResult);
+            fResult = NULL;
+        }
+        std::string GetName() const {return "TPlotDigitsHits::FillTask";}
+    private:
+        const std::vector<const CP::TDigit*>& fDigits;
+        const std::vector<int>& fWires;
+        std::size_t fBegin;
+        std::size_t fEnd;
+        const TAxis& fXAxis;
+        const TAxis& fYAxis;
+        double fMedianSample;
+        TFillResult* fResult;
+        CP::TResultQueue& fResults;
+    };
+
+    /// Split the digits of a plane into chunks with about the same number of
+    /// samples, and fill each chunk in a subtask (a TFillTask).  The number
+    /// of samples in a digit varies a lot (e.g. the deconvolved digits are
+    /// cut around the signal), so chunks with the same number of digits
+    /// take very different times.  Counting the samples touches every
+    /// digit, so it's done here instead of on the main thread, and the
+    /// subtasks are queued on the thread running this task (see
+    /// CP::TTaskPool) where the idle threads steal them.
+    class TSplitTask: public CP::TVTask {
+    public:
+        TSplitTask(CP::TTaskPool& pool, CP::TTaskPool::Group& group,
+                   const std::vector<const CP::TDigit*>& digits,
+                   const std::vector<int>& wires,
+                   const TAxis& xAxis, const TAxis& yAxis,
+                   double medianSample, TH2F* digitPlot, bool samplesInTime,
+                   double& maxVal, CP::TResultQueue& results)
+            : fPool(pool), fGroup(group), fDigits(digits), fWires(wires),
+              fXAxis(xAxis), fYAxis(yAxis), fMedianSample(medianSample),
+              fDigitPlot(digitPlot), fSamplesInTime(samplesInTime),
+              fMaxVal(maxVal), fResults(results) {}
+        void Execute() {
+            std::size_t total = 0;
+            for (std::size_t d = 0; d < fDigits.size(); ++d) {
+                total += CP::TEventSummary::GetDigitSampleCount(fDigits[d]);
+            }
+            // A few chunks for each thread so that the histogram fills in
+            // small steps, and the threads stay busy to the end.
+            std::size_t chunks = 4*fPool.GetThreadCount();
+            std::size_t target = std::max(std::size_t(1), total/chunks);
+            std::size_t begin = 0;
+            std::size_t samples = 0;
+            for (std::size_t d = 0; d < fDigits.size(); ++d) {
+                if (IsCancelled()) return;
+                samples += CP::TEventSummary::GetDigitSampleCount(fDigits[d]);
+                if (samples < target && d+1 < fDigits.size()) continue;
+                TFillResult* result = new TFillResult(fDigitPlot,
+                                                      fSamplesInTime,
+                                                      fMaxVal);
+                fPool.Submit(new TFillTask(fDigits, fWires, begin, d+1,
+                                           fXAxis, fYAxis, fMedianSample,
+                                           result, fResults),
+                             fGroup);
+                begin = d+1;
+                samples = 0;
+            }
+        }
+        std::string GetName() const {return "TPlotDigitsHits::SplitTask";}
+    private:
+        CP::TTaskPool& fPool;
+        CP::TTaskPool::Group& fGroup;
+        const std::vector<const CP::TDigit*>& fDigits;
+        const std::vector<int>& fWires;
+        const TAxis& fXAxis;
+        const TAxis& fYAxis;
+        double fMedianSample;
+        TH2F* fDigitPlot;
+        bool fSamplesInTime;
+        double& fMaxVal;
+        CP::TResultQueue& fResults;
+    };
+};
 
-    double GetDigitLastTime(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetFirstSample()+pulse->GetSampleCount();
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetLastSample()/unit::microsecond;
-        return 0.0;
+/// Fill the histogram of digits for one plane without blocking the GUI.
+/// The samples are sorted into bins by tasks in the CP::TTaskPool (a
+/// TSplitTask and its TFillTask subtasks), the bins are added to the
+/// histogram on the main thread, and the histogram is drawn when all of the
+/// digits have been added.
+class CP::TPlotDigitsHits::FillJob: public CP::TVJob {
+public:
+    FillJob(CP::TPlotDigitsHits& plot, int plane, TH2F* digitPlot,
+            const CP::TEventSummary::Digits& digits, bool samplesInTime,
+            int overSampling, double timeUnit, double timeOffset)
+        : fPlot(plot), fPlane(plane), fDigitPlot(digitPlot),
+          fDigits(digits.digits), fWires(digits.wires),
+          fXAxis(*digitPlot->GetXaxis()), fYAxis(*digitPlot->GetYaxis()),
+          fOverSampling(overSampling), fTimeUnit(timeUnit),
+          fTimeOffset(timeOffset), fMaxVal(10),
+          fStart(CP::TTimingTable::GetTime()) {
+        // The fill tasks are submitted to the same group by the split task,
+        // so the group isn't done until all of them have finished.
+        CP::TTaskPool& pool = CP::TEventDisplay::Get().Tasks();
+        pool.Submit(new TSplitTask(pool, fGroup, fDigits, fWires,
+                                   fXAxis, fYAxis, digits.medianSample,
+                                   fDigitPlot, samplesInTime, fMaxVal,
+                                   fResults),
+                    fGroup);
     }
 
-    std::size_t GetDigitSampleCount(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetSampleCount();
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetSampleCount();
-        return 0;
+    bool Step(double seconds) {
+        double start = CP::TTimingTable::GetTime();
+        CP::TTaskPool& pool = CP::TEventDisplay::Get().Tasks();
+        if (pool.GetThreadCount() < 2) {
+            while (CP::TTimingTable::GetTime() - start < seconds
+                   && pool.RunOne()) {}
+        }
+        bool done = pool.IsDone(fGroup);
+        fResults.Run(std::max(0.0,
+                              seconds - (CP::TTimingTable::GetTime()-start)));
+        if (!done || !fResults.IsEmpty()) return false;
+        fPlot.FinishDigits(fPlane, fDigitPlot, fMaxVal, fOverSampling,
+                           fTimeUnit, fTimeOffset);
+        CP::TEventDisplay::Get().Budget().AddCost(
+            "Digits", CP::TTimingTable::GetTime() - fStart);
+        return true;
     }
 
-    // This will be 3200 for raw digits and 0 for calibrated digits.
-    double GetDigitTriggerOffset(const CP::TDigit* d) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (!pulse) return 0.0;
-        CP::TChannelCalib chanCalib;
-        double off = chanCalib.GetTimeConstant(pulse->GetChannelId(),0);
-        double tim = chanCalib.GetTimeConstant(pulse->GetChannelId(),1);
-        return - off/tim;
+    void Cancel() {
+        CP::TTaskPool& pool = CP::TEventDisplay::Get().Tasks();
+        pool.Cancel(fGroup);
+        pool.Wait(fGroup);
+        fResults.Clear();
     }
 
-    // This will be 1 for raw digits and 500ns for calibrated digits.
-    double GetDigitSampleStep(const CP::TDigit* d) {
-        double diff = GetDigitLastTime(d) - GetDigitFirstTime(d);
-        return diff/GetDigitSampleCount(d);
-    }
+    std::string GetName() const {return GetJobName(fPlane);}
 
-    double GetDigitSample(const CP::TDigit* d, int i) {
-        const CP::TPulseDigit* pulse 
-            = dynamic_cast<const CP::TPulseDigit*>(d);
-        if (pulse) return pulse->GetSample(i);
-        const CP::TCalibPulseDigit* calib 
-            = dynamic_cast<const CP::TCalibPulseDigit*>(d);
-        if (calib) return calib->GetSample(i);
-        return 0;
+    double GetProgress() const {
+        int finished = 0;
+        int submitted = 0;
+        CP::TEventDisplay::Get().Tasks().GetProgress(fGroup, finished,
+                                                     submitted);
+        if (submitted < 1) return 1.0;
+        return double(finished)/submitted;
     }
 
+private:
+    CP::TPlotDigitsHits& fPlot;
+    int fPlane;
+    TH2F* fDigitPlot;
+
+    /// Copies of the digits in the plane, and their wire numbers.
+    std::vector<const CP::TDigit*> fDigits;
+    std::vector<int> fWires;
+
+    /// Copies of the histogram axes used by the tasks.
+    TAxis fXAxis;
+    TAxis fYAxis;
+
+    int fOverSampling;
+    double fTimeUnit;
+    double fTimeOffset;
+
+    /// The largest bin content.
+    double fMaxVal;
 
+    /// The time the job was started.  The time to fill and draw the plot is
+    /// added to the CP::TFrameBudget.
+    double fStart;
+
+    /// The group is changed by the pool while the tasks run.
+    mutable CP::TTaskPool::Group fGroup;
+    CP::TResultQueue fResults;
 };
 
 CP::TPlotDigitsHits::TPlotDigitsHits()
@@ -99,15 +307,45 @@ CP::TPlotDigitsHits::TPlotDigitsHits()
 
 CP::TPlotDigitsHits::~TPlotDigitsHits() {}
 
+void CP::TPlotDigitsHits::AddEventPaths(std::vector<std::string>& paths) {
+    paths.push_back("~/digits/drift");
+    if (CP::TEventDisplay::Get().GUI().GetShowDeconvDigitsButton()->IsOn()) {
+        paths.push_back("~/digits/drift-deconv");
+    }
+    if (CP::TEventDisplay::Get().GUI().GetShowDecorrelDigitsButton()->IsOn()) {
+        paths.push_back("~/digits/drift-correl");
+    }
+    if (CP::TEventDisplay::Get().GUI().GetShowCalibDigitsButton()->IsOn()) {
+        paths.push_back("~/digits/drift-calib");
+    }
+    paths.push_back("~/hits/drift");
+    paths.push_back("~/hits/pmt");
+}
+
 void CP::TPlotDigitsHits::DrawDigits(int plane) {
-    CP::TChannelCalib chanCalib;
+    CP::TScopedTimer timer("TPlotDigitsHits::DrawDigits");
     double wireTimeStep = -1.0;
 
+    // Stop filling the old histogram for this plane before it's deleted.
+    CP::TEventDisplay::Get().EventChange().CancelJob(GetJobName(plane));
+
+    // Make sure the folders needed for the plot have been read.
+    std::vector<std::string> paths;
+    AddEventPaths(paths);
+    std::ostringstream method;
+    method << "DrawDigits(=" << plane << ")";
+    if (!CP::TEventDisplay::Get().EventChange().LoadEventPaths(
+            paths, "CP::TPlotDigitsHits", this, method.str().c_str())) {
+        return;
+    }
+
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
 
     // Get the default digits to be drawn.
+    std::string driftPath = "~/digits/drift";
     CP::THandle<CP::TDigitContainer> drift
-        = event->Get<CP::TDigitContainer>("~/digits/drift");
+        = CP::TEventDisplay::Get().Handles().Get<CP::TDigitContainer>(
+            *event, driftPath);
 
     // Check if the user wanted to see deconvolved digits.  Raw digits are
     // used if the deconvonvolved digits aren't found.
@@ -115,31 +353,37 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
     if (CP::TEventDisplay::Get().GUI().GetShowDeconvDigitsButton()->IsOn()
         or !drift) {
         CP::THandle<CP::TDigitContainer> tmp
-            = event->Get<CP::TDigitContainer>("~/digits/drift-deconv");
+            = CP::TEventDisplay::Get().Handles().Get<CP::TDigitContainer>(
+                *event, "~/digits/drift-deconv");
         // If deconvolved digits are found, then use them.
         if (tmp) {
             samplesInTime = true;
             drift = tmp;
+            driftPath = "~/digits/drift-deconv";
         } 
     }
     if (CP::TEventDisplay::Get().GUI().GetShowDecorrelDigitsButton()->IsOn()
         or !drift) {
         CP::THandle<CP::TDigitContainer> tmp
-            = event->Get<CP::TDigitContainer>("~/digits/drift-correl");
+            = CP::TEventDisplay::Get().Handles().Get<CP::TDigitContainer>(
+                *event, "~/digits/drift-correl");
         // If decorrelated digits are found, then use them.
         if (tmp) {
             samplesInTime = true;
             drift = tmp;
+            driftPath = "~/digits/drift-correl";
         } 
     }
     if (CP::TEventDisplay::Get().GUI().GetShowCalibDigitsButton()->IsOn()
         or !drift) {
         CP::THandle<CP::TDigitContainer> tmp
-            = event->Get<CP::TDigitContainer>("~/digits/drift-calib");
+            = CP::TEventDisplay::Get().Handles().Get<CP::TDigitContainer>(
+                *event, "~/digits/drift-calib");
         // If calib digits are found, then use them.
         if (tmp) {
             samplesInTime = true;
             drift = tmp;
+            driftPath = "~/digits/drift-calib";
         } 
     }
     
@@ -202,93 +446,32 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
     double signalEnd = -1E+6;
     int signalBins = 0;
 
-    // Find the Z axis range for the histogram.  The median samples the
-    // middle.  The max and min are the "biggest" distance from the median.
-    std::vector<double> samples;
+    // Find the Z axis range for the histogram, and the time axis range.
+    // These come from the event summary, so they are only found once for
+    // each event.
+    CP::TEventSummary& summary = CP::TEventDisplay::Get().Summary();
+    const CP::TEventSummary::Digits* digits = NULL;
     double medianSample = 0.0;
     if (drift) {
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            // Figure out if this is in the right plane, and get the wire
-            // number.
-            const CP::TDigit* digit 
-                = dynamic_cast<const CP::TDigit*>(*d);
-            if (!digit) continue;
-            CP::TGeometryId id 
-                = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
-            if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
-            // Save the sample to find the median.
-            for (std::size_t i = 0; i < GetDigitSampleCount(*d); ++i) {
-                double s = GetDigitSample(*d,i);
-                if (!std::isfinite(s)) continue;
-                samples.push_back(s);
-            }
-            if (digitSampleStep < 0) {
-                // Find the time range.
-                digitSampleStep = GetDigitSampleStep(*d);
-                digitSampleOffset = GetDigitTriggerOffset(*d);
-            }
-            if (wireTimeStep < 0.0) {
-                wireTimeStep=chanCalib.GetTimeConstant(
-                    (*d)->GetChannelId(),1);
-            }
-        }
+        digits = &summary.GetDigits(driftPath, plane);
         
         // Crash prevention.  It shouldn't be possible to have digits without
         // any samples, but...
-        if (samples.empty()) return;
-        
-        std::sort(samples.begin(),samples.end());
-        medianSample = samples[0.5*samples.size()];
-
-        double maxSample = std::abs(samples[0.99*samples.size()]-medianSample);
-        double s = std::abs(samples[0.01*samples.size()]-medianSample);
-        maxSample = std::max(maxSample,s);
-        
-        // Find the time axis range based on the times of the bins with a
-        // signal.  In most files, the result will be the full range of the
-        // digitizer 0-9595, or the full range of the calibrated times (-1600
-        // usec to 3197 usec), but things get a little more complicated for the
-        // MC.
-        std::vector<double> times;
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            // Figure out if this is in the right plane, and get the wire
-            // number.
-            const CP::TDigit* digit 
-                = dynamic_cast<const CP::TDigit*>(*d);
-            if (!digit) continue;
-            CP::TGeometryId id 
-                = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
-            if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
-            double maxSignal = 0.0;
-            for (std::size_t i = 0; i < GetDigitSampleCount(*d); ++i) {
-                double s = std::abs(GetDigitSample(*d,i) - medianSample);
-                if (!std::isfinite(s)) continue;
-                if (maxSignal < s) maxSignal = s;
-            }
-            if (maxSignal < 0.25*maxSample) continue;
-            times.push_back(GetDigitFirstTime(*d));
-            times.push_back(GetDigitLastTime(*d));
-        }
-        std::sort(times.begin(),times.end());
-    
-        signalStart = times[0.01*times.size()];
-        signalEnd = times[0.99*times.size()];
+        if (digits->sampleCount < 1) return;
+
+        medianSample = digits->medianSample;
+        digitSampleStep = digits->sampleStep;
+        digitSampleOffset = digits->triggerOffset;
+        wireTimeStep = digits->wireTimeStep;
+        signalStart = digits->signalStart;
+        signalEnd = digits->signalEnd;
         signalBins = (signalEnd-signalStart)/digitSampleStep;
     }
-    else if (event->Get<CP::THitSelection>("~/hits/drift")) {
-        CP::THandle<CP::THitSelection> hits
-            = event->Get<CP::THitSelection>("~/hits/drift");
-        for (CP::THitSelection::iterator h = hits->begin();
-             h != hits->end(); ++h) {
-            if (signalStart>(*h)->GetTime()) signalStart = (*h)->GetTime();
-            if (signalEnd<(*h)->GetTime()) signalEnd = (*h)->GetTime();
-            TChannelId cid = (*h)->GetChannelId();
-            if (wireTimeStep < 0) {
-                wireTimeStep = chanCalib.GetTimeConstant(cid,1);
-            }
-        }
+    else if (summary.GetDriftHits().hits.size() > 0) {
+        const CP::TEventSummary::Hits& hits = summary.GetDriftHits();
+        signalStart = hits.minTime;
+        signalEnd = hits.maxTime;
+        wireTimeStep = hits.wireTimeStep;
         signalBins = 10000;
         digitSampleStep = 0.5;
         digitSampleOffset = 0.0;
@@ -336,6 +519,12 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
         // one bin.
         overSampling = 20.0;
     }
+    if (showDigitSamples) {
+        // Put more samples into each bin if the plots have been too slow.
+        overSampling
+            = CP::TEventDisplay::Get().Budget().GetDigitOverSampling(
+                overSampling);
+    }
     signalBins /= overSampling;
     
     ////////////////////////////////////////////////////////////////
@@ -404,48 +593,56 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
     digitPlot->Draw("");
     gPad->Update();
 
-    // Fill the histogram.
-    double maxVal = 10;
-    if (drift) {
-        for (CP::TDigitContainer::const_iterator d = drift->begin();
-             d != drift->end(); ++d) {
-            // Figure out if this is in the right plane, and get the wire
-            // number.
-            const CP::TDigit* digit 
-                = dynamic_cast<const CP::TDigit*>(*d);
-            if (!digit) continue;
-            CP::TGeometryId id 
-                = CP::TChannelInfo::Get().GetGeometry(digit->GetChannelId());
-            if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
-            // Plot the digits for this channel.
-            if (!showDigitSamples) continue;
-            double wire = CP::GeomId::Captain::GetWireNumber(id) + 0.5;
-            for (std::size_t i = 0; i < GetDigitSampleCount(digit); ++i) {
-                double tbin = GetDigitFirstTime(digit) 
-                    + GetDigitSampleStep(digit)*i;
-                double sample = GetDigitSample(digit,i)-medianSample;
-                if (!std::isfinite(sample)) continue;
-                int bin = digitPlot->FindFixBin(wire,tbin+1E-6);
-                double val = digitPlot->GetBinContent(bin);
-                if (samplesInTime) { 
-                    // Samples in time mean that the calibrated (and
-                    // deconvolved) signals are being plotted.  In this case,
-                    // we should plot the cumulative charge in each bin.
-                    digitPlot->SetBinContent(bin,val+sample);
-                }
-                else if (std::abs(sample) > std::abs(val)) { 
-                    // There may be more than one sample per histogram bin (to
-                    // make the plotting faster), so plot the maximum sample
-                    // value in the histogram bin.
-                    digitPlot->SetBinContent(bin,sample);
-                }
-                digitPlot->SetBinError(bin,1.0);
-                val = digitPlot->GetBinContent(bin);
-                maxVal = std::max(maxVal,val);
-            }
-        }
+    // The number of nanoseconds per unit on the digit histogram.
+    double timeUnit =  wireTimeStep/digitSampleStep;
+
+    // Fill the histogram in the background.  The histogram is drawn with
+    // the hits when it's full.
+    if (digits && showDigitSamples) {
+        CP::TEventDisplay::Get().EventChange().AddJob(
+            new FillJob(*this, plane, digitPlot, *digits, samplesInTime,
+                        overSampling, timeUnit, digitSampleOffset));
+        return;
     }
-    
+
+    FinishDigits(plane, digitPlot, 10, overSampling,
+                 timeUnit, digitSampleOffset);
+}
+
+std::string CP::TPlotDigitsHits::GetJobName(int plane) {
+    switch (plane) {
+    case 0: return "X Digits";
+    case 1: return "V Digits";
+    case 2: return "U Digits";
+    }
+    return "Digits";
+}
+
+void CP::TPlotDigitsHits::FinishDigits(int plane, TH2F* digitPlot,
+                                       double maxVal, int overSampling,
+                                       double timeUnit, double timeOffset) {
+    CP::TScopedTimer timer("TPlotDigitsHits::FinishDigits");
+
+    // Other planes may have been drawn while the histogram was filled, so
+    // find the canvas again.  It's gone if the user closed it.
+    TCanvas* canvas = NULL;
+    switch (plane) {
+    case 0:
+        canvas = (TCanvas*) gROOT->FindObject("canvasXDigits");
+        fCurrentGraphicsDelete = &fGraphicsXDelete;
+        break;
+    case 1:
+        canvas = (TCanvas*) gROOT->FindObject("canvasVDigits");
+        fCurrentGraphicsDelete = &fGraphicsVDelete;
+        break;
+    case 2:
+        canvas = (TCanvas*) gROOT->FindObject("canvasUDigits");
+        fCurrentGraphicsDelete = &fGraphicsUDelete;
+        break;
+    }
+    if (!canvas) return;
+    canvas->cd();
+
 #ifdef USE_ABSOLUTE_MAXIMUM
     maxVal= std::min(maxVal,overSampling*10000.0);
 #else
@@ -479,24 +676,20 @@ void CP::TPlotDigitsHits::DrawDigits(int plane) {
     ////////////////////////////////////////////////////////////
     // Now plot the PMT and TPC hit times on the histogram.
     ////////////////////////////////////////////////////////////
-
-    // The number of nanoseconds per unit on the digit histogram.
-    double timeUnit =  wireTimeStep/digitSampleStep;
-    
-    DrawPMTHits(timeUnit, digitSampleOffset);
-    DrawTPCHits(plane, timeUnit, digitSampleOffset);
+    DrawPMTHits(timeUnit, timeOffset);
+    DrawTPCHits(plane, timeUnit, timeOffset);
 
     gPad->Update();
 }
 
 void CP::TPlotDigitsHits::DrawPMTHits(double timeUnit,
                                       double triggerOffset) {
-    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
-    CP::THandle<CP::THitSelection> pmts
-        = event->Get<CP::THitSelection>("~/hits/pmt");
-    if (pmts) {
-        for (CP::THitSelection::iterator h = pmts->begin();
-             h != pmts->end(); ++h) {
+    const CP::TEventSummary::Hits& pmts
+        = CP::TEventDisplay::Get().Summary().GetPMTHits();
+    if (!pmts.hits.empty()) {
+        for (std::vector< CP::THandle<CP::THit> >::const_iterator h
+                 = pmts.hits.begin();
+             h != pmts.hits.end(); ++h) {
             double dTime = (*h)->GetTime()/timeUnit + triggerOffset;
             int n=0;
             double px[10];
@@ -517,11 +710,9 @@ void CP::TPlotDigitsHits::DrawPMTHits(double timeUnit,
 void CP::TPlotDigitsHits::DrawTPCHits(int plane,
                                       double timeUnit,
                                       double triggerOffset) {
-    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
-    CP::THandle<CP::THitSelection> hits
-        = event->Get<CP::THitSelection>("~/hits/drift");
+    CP::TEventSummary& summary = CP::TEventDisplay::Get().Summary();
 
-    if (hits && hits->size()>1) {
+    if (summary.GetDriftHits().hits.size()>1) {
         TBox* box1 = new TBox(0.0, 0.0, 1.0, 1.0);
         box1->SetFillColor(kGreen-7);
         fCurrentGraphicsDelete->push_back(box1);
@@ -612,11 +803,12 @@ void CP::TPlotDigitsHits::DrawTPCHits(int plane,
         fCurrentGraphicsDelete->push_back(hitChargeLegend);
         hitChargeLegend->Draw();
 
-        for (CP::THitSelection::iterator h = hits->begin();
-             h != hits->end(); ++h) {
+        // Only the hits in the plane are drawn.
+        const CP::TEventSummary::Hits& hits = summary.GetDriftHits(plane);
+        for (std::vector< CP::THandle<CP::THit> >::const_iterator h
+                 = hits.hits.begin();
+             h != hits.hits.end(); ++h) {
             TGeometryId id = (*h)->GetGeomId();
-            TChannelId cid = (*h)->GetChannelId();
-            if (CP::GeomId::Captain::GetWirePlane(id) != plane) continue;
             // The wire number (offset for the middle of the bin).
             double wire = CP::GeomId::Captain::GetWireNumber(id) + 0.5;
             // The hit charge
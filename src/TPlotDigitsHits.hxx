@@ -1,5 +1,6 @@
 #ifndef TPlotDigitsHits_hxx_seen
 #define TPlotDigitsHits_hxx_seen
+#include <string>
 #include <vector>
 
 namespace CP {
@@ -21,7 +22,24 @@ public:
     /// separate canvas.
     void DrawDigits(int proj);
 
+    /// Add the event paths read by DrawDigits() with the current GUI
+    /// settings.
+    void AddEventPaths(std::vector<std::string>& paths);
+
 private:
+    /// Fill the histogram for a plane in the background.
+    class FillJob;
+
+    /// Get the name of the job filling the histogram for a plane (see
+    /// CP::TEventChangeManager::AddJob()).
+    static std::string GetJobName(int plane);
+
+    /// Set the histogram range, draw the histogram for a plane, and then
+    /// draw the hits on top of it.  This is called after the histogram has
+    /// been filled.  The maxVal is the largest bin content.  The time unit
+    /// and offset are described by DrawTPCHits().
+    void FinishDigits(int plane, TH2F* digitPlot, double maxVal,
+                      int overSampling, double timeUnit, double timeOffset);
 
     // Draw the TPC hits onto a histogram that was created to draw the digits.
     // The digit histogram will usually have a "time" axis in either samples,
@@ -1,6 +1,9 @@
 #include "TPlotHitSamples.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TScopedTimer.hxx"
+#include "TEventSummary.hxx"
 
 #include <TEvent.hxx>
 #include <THit.hxx>
@@ -32,12 +35,24 @@ CP::TPlotHitSamples::~TPlotHitSamples() {
     fGraphicsDelete.clear();
 }
 
+void CP::TPlotHitSamples::AddEventPaths(std::vector<std::string>& paths) {
+    // The hit samples are found through the digits used by the hits.
+    paths.push_back("~/hits/drift");
+    paths.push_back("~/digits");
+}
+
 void CP::TPlotHitSamples::DrawHitSamples() {
-    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
+    CP::TScopedTimer timer("TPlotHitSamples::DrawHitSamples");
+    // Make sure the folders needed for the plot have been read.
+    std::vector<std::string> paths;
+    AddEventPaths(paths);
+    if (!CP::TEventDisplay::Get().EventChange().LoadEventPaths(
+            paths, "CP::TPlotHitSamples", this, "DrawHitSamples()")) {
+        return;
+    }
 
-    CP::THandle<CP::THitSelection> hits
-        = event->Get<CP::THitSelection>("~/hits/drift");
-    if (!hits) {
+    CP::TEventSummary& summary = CP::TEventDisplay::Get().Summary();
+    if (summary.GetDriftHits().hits.empty()) {
         CaptError("No hits to draw");
         return;
     }
@@ -88,19 +103,13 @@ void CP::TPlotHitSamples::DrawHitSamples() {
     minDigitTime *= unit::microsecond;
     maxDigitTime *= unit::microsecond;
     
-    // Find the hit to draw.
+    // Find the hit to draw.  Only the hits in the plane of the digit canvas
+    // are checked.
     CP::THandle<THit> hit;
-    for (CP::THitSelection::iterator h = hits->begin();
-         h != hits->end(); ++h) {
-        if (dType == 0 && !CP::GeomId::Captain::IsXWire((*h)->GetGeomId())){
-            continue;
-        }
-        if (dType == 1 && !CP::GeomId::Captain::IsVWire((*h)->GetGeomId())){
-            continue;
-        }
-        if (dType == 2 && !CP::GeomId::Captain::IsUWire((*h)->GetGeomId())){
-            continue;
-        }
+    const CP::TEventSummary::Hits& hits = summary.GetDriftHits(dType);
+    for (std::vector< CP::THandle<CP::THit> >::const_iterator h
+             = hits.hits.begin();
+         h != hits.hits.end(); ++h) {
         if ((*h)->GetTime() < minDigitTime) continue;
         if ((*h)->GetTime() > maxDigitTime) continue;
         double wire = CP::GeomId::Captain::GetWireNumber((*h)->GetGeomId());
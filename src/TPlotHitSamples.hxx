@@ -1,5 +1,6 @@
 #ifndef TPlotHitSamples_hxx_seen
 #define TPlotHitSamples_hxx_seen
+#include <string>
 #include <vector>
 
 namespace CP {
@@ -19,6 +20,9 @@ public:
     /// Draw the charge vs time in a graph.
     void DrawHitSamples();
 
+    /// Add the event paths read by DrawHitSamples().
+    void AddEventPaths(std::vector<std::string>& paths);
+
 private:
 
     /// Things to delete.
@@ -1,6 +1,9 @@
 #include "TPlotTimeCharge.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEventChangeManager.hxx"
+#include "TScopedTimer.hxx"
+#include "TEventSummary.hxx"
 
 #include <TEvent.hxx>
 #include <TEventContext.hxx>
@@ -86,6 +89,7 @@ namespace {
 }
 
 void CP::TPlotTimeCharge::FitTimeCharge() {
+    CP::TScopedTimer timer("TPlotTimeCharge::FitTimeCharge");
     TCanvas* canvas = (TCanvas*) gROOT->FindObject("canvasTimeCharge");
     if (!canvas) return;
     
@@ -249,13 +253,25 @@ void CP::TPlotTimeCharge::FitTimeCharge() {
     gPad->Update();
 }
 
+void CP::TPlotTimeCharge::AddEventPaths(std::vector<std::string>& paths) {
+    paths.push_back("~/hits/drift");
+}
+
 void CP::TPlotTimeCharge::DrawTimeCharge() {
+    CP::TScopedTimer timer("TPlotTimeCharge::DrawTimeCharge");
+
+    // Make sure the folders needed for the plot have been read.
+    std::vector<std::string> paths;
+    AddEventPaths(paths);
+    if (!CP::TEventDisplay::Get().EventChange().LoadEventPaths(
+            paths, "CP::TPlotTimeCharge", this, "DrawTimeCharge()")) {
+        return;
+    }
 
     CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
 
-    CP::THandle<CP::THitSelection> hits
-        = event->Get<CP::THitSelection>("~/hits/drift");
-    if (!hits) {
+    CP::TEventSummary& summary = CP::TEventDisplay::Get().Summary();
+    if (summary.GetDriftHits().hits.empty()) {
         CaptError("No hits to draw");
         return;
     }
@@ -335,9 +351,10 @@ void CP::TPlotTimeCharge::DrawTimeCharge() {
 
     // Fill the graph for the U hits
     points = 0;
-    for (CP::THitSelection::iterator h = hits->begin();
-         h != hits->end(); ++h) {
-        if (!CP::GeomId::Captain::IsUWire((*h)->GetGeomId())) continue;
+    const CP::TEventSummary::Hits& uHits = summary.GetDriftHits(2);
+    for (std::vector< CP::THandle<CP::THit> >::const_iterator h
+             = uHits.hits.begin();
+         h != uHits.hits.end(); ++h) {
         if (!drawUHits) continue;
         if ((*h)->GetTime() < minDigitTime) continue;
         if ((*h)->GetTime() > maxDigitTime) continue;
@@ -368,9 +385,10 @@ void CP::TPlotTimeCharge::DrawTimeCharge() {
 
     // Fill the graph for the V hits.
     points = 0;
-    for (CP::THitSelection::iterator h = hits->begin();
-         h != hits->end(); ++h) {
-        if (!CP::GeomId::Captain::IsVWire((*h)->GetGeomId())) continue;
+    const CP::TEventSummary::Hits& vHits = summary.GetDriftHits(1);
+    for (std::vector< CP::THandle<CP::THit> >::const_iterator h
+             = vHits.hits.begin();
+         h != vHits.hits.end(); ++h) {
         if (!drawVHits) continue;
         if ((*h)->GetTime() < minDigitTime) continue;
         if ((*h)->GetTime() > maxDigitTime) continue;
@@ -401,9 +419,10 @@ void CP::TPlotTimeCharge::DrawTimeCharge() {
     
     // Fill the graph for the X hits.
     points=0;
-    for (CP::THitSelection::iterator h = hits->begin();
-         h != hits->end(); ++h) {
-        if (!CP::GeomId::Captain::IsXWire((*h)->GetGeomId())) continue;
+    const CP::TEventSummary::Hits& xHits = summary.GetDriftHits(0);
+    for (std::vector< CP::THandle<CP::THit> >::const_iterator h
+             = xHits.hits.begin();
+         h != xHits.hits.end(); ++h) {
         if (!drawXHits) continue;
         if ((*h)->GetTime() < minDigitTime) continue;
         if ((*h)->GetTime() > maxDigitTime) continue;
@@ -1,5 +1,6 @@
 #ifndef TPlotTimeCharge_hxx_seen
 #define TPlotTimeCharge_hxx_seen
+#include <string>
 #include <vector>
 
 namespace CP {
@@ -25,6 +26,9 @@ public:
     /// Fit the charge vs time in a graph.
     void FitTimeCharge();
 
+    /// Add the event paths read by DrawTimeCharge().
+    void AddEventPaths(std::vector<std::string>& paths);
+
 private:
 
     /// The graphs...
@@ -1,5 +1,6 @@
 #include "TReconShowerElement.hxx"
 #include "TMatrixElement.hxx"
+#include "TShapeFactory.hxx"
 
 #include <TCaptLog.hxx>
 #include <HEPUnits.hxx>
@@ -10,9 +11,6 @@
 #include <TShowerState.hxx>
 #include <THandle.hxx>
 
-#include <TGeoManager.h>
-#include <TGeoShape.h>
-#include <TGeoSphere.h>
 #include <TGeoMatrix.h>
 
 #include <TEveLine.h>
@@ -123,11 +121,8 @@ CP::TReconShowerElement::TReconShowerElement(CP::TReconShower& shower,
                               nodeState->GetPosition().Y(),
                               nodeState->GetPosition().Z());
         nodeShape->SetTransMatrix(trans);
-        TGeoManager* saveGeom = gGeoManager;
-        gGeoManager = nodeShape->GetGeoMangeur();
-        TGeoShape* geoShape = new TGeoSphere(0.0, nodeWidth);
-        nodeShape->SetShape(geoShape);
-        gGeoManager = saveGeom;
+        CP::TShapeFactory::SetShape(
+            nodeShape, CP::TShapeFactory::MakeSphere(nodeWidth));
         AddElement(nodeShape);
     }    
 }
@@ -0,0 +1,55 @@
+#include "TResultQueue.hxx"
+#include "TVTask.hxx"
+#include "TTimingTable.hxx"
+
+#include <TVirtualMutex.h>
+
+CP::TResultQueue::TResultQueue() : fLock(kTRUE) {}
+
+CP::TResultQueue::~TResultQueue() {
+    Clear();
+}
+
+void CP::TResultQueue::Post(CP::TVTask* result) {
+    if (!result) return;
+    TLockGuard guard(&fLock);
+    fResults.push_back(result);
+}
+
+int CP::TResultQueue::Run(double seconds) {
+    double start = CP::TTimingTable::GetTime();
+    int count = 0;
+    while (true) {
+        CP::TVTask* result = NULL;
+        {
+            TLockGuard guard(&fLock);
+            if (fResults.empty()) break;
+            result = fResults.front();
+            fResults.pop_front();
+        }
+        // The lock isn't held while the result runs, so the workers can keep
+        // posting.
+        result->Execute();
+        delete result;
+        ++count;
+        if (CP::TTimingTable::GetTime() - start > seconds) break;
+    }
+    return count;
+}
+
+void CP::TResultQueue::Clear() {
+    std::deque<CP::TVTask*> results;
+    {
+        TLockGuard guard(&fLock);
+        results.swap(fResults);
+    }
+    for (std::deque<CP::TVTask*>::iterator r = results.begin();
+         r != results.end(); ++r) {
+        delete (*r);
+    }
+}
+
+bool CP::TResultQueue::IsEmpty() {
+    TLockGuard guard(&fLock);
+    return fResults.empty();
+}
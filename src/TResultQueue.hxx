@@ -0,0 +1,47 @@
+#ifndef TResultQueue_hxx_seen
+#define TResultQueue_hxx_seen
+
+#include <TMutex.h>
+
+#include <deque>
+
+namespace CP {
+    class TResultQueue;
+    class TVTask;
+};
+
+/// A thread safe queue used to pass results from the CP::TTaskPool threads
+/// back to the main thread.  A result is a CP::TVTask that is posted by a
+/// worker, and is run (and deleted) on the main thread by Run().  Since the
+/// results are run on the main thread, they can use the GUI and gEve.
+class CP::TResultQueue {
+public:
+    TResultQueue();
+
+    /// Delete the results that haven't been run.
+    ~TResultQueue();
+
+    /// Add a result to the queue, and take ownership of it.  This can be
+    /// called from any thread.
+    void Post(CP::TVTask* result);
+
+    /// Run the posted results on the calling thread until the queue is
+    /// empty, or until "seconds" have been used.  At least one result is run
+    /// if the queue isn't empty.  This returns the number of results that
+    /// were run.
+    int Run(double seconds);
+
+    /// Delete the results that haven't been run.
+    void Clear();
+
+    /// Check if there are results waiting to be run.
+    bool IsEmpty();
+
+private:
+    /// The posted results.
+    std::deque<CP::TVTask*> fResults;
+
+    /// The lock protecting the results.
+    TMutex fLock;
+};
+#endif
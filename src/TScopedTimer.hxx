@@ -0,0 +1,50 @@
+#ifndef TScopedTimer_hxx_seen
+#define TScopedTimer_hxx_seen
+
+#include "TTimingTable.hxx"
+
+#include <string>
+
+namespace CP {
+    class TScopedTimer;
+};
+
+/// Measure the time until the end of the scope, and add it to the
+/// CP::TTimingTable.  When the timing is disabled, this only checks for the
+/// enabled table (see CP::TTimingTable::GetActive()), so timers can be left
+/// in the code.  The name is built from the
+/// two parts (e.g. the handler name and "::Build") only when timing is
+/// enabled.
+///
+/// \code
+/// {
+///     CP::TScopedTimer timer("Redraw3D");
+///     gEve->Redraw3D(kTRUE);
+/// }
+/// \endcode
+class CP::TScopedTimer {
+public:
+    explicit TScopedTimer(const char* name, const char* suffix = NULL)
+        : fTable(CP::TTimingTable::GetActive()), fStart(0.0) {
+        if (!fTable) return;
+        fName = name;
+        if (suffix) fName += suffix;
+        fStart = CP::TTimingTable::GetTime();
+    }
+
+    ~TScopedTimer() {
+        if (!fTable) return;
+        fTable->Add(fName, CP::TTimingTable::GetTime() - fStart);
+    }
+
+private:
+    /// The table to fill (NULL if timing is disabled).
+    CP::TTimingTable* fTable;
+
+    /// The name of the timer.
+    std::string fName;
+
+    /// The start time in seconds.
+    double fStart;
+};
+#endif
@@ -0,0 +1,34 @@
+#include "TShapeFactory.hxx"
+#include "TVEventChangeHandler.hxx"
+
+#include <TGeoShape.h>
+#include <TGeoEltu.h>
+#include <TGeoSphere.h>
+#include <TEveGeoShape.h>
+#include <TEveUtil.h>
+#include <TVirtualMutex.h>
+
+TGeoShape* CP::TShapeFactory::MakeEltu(double a, double b, double dz) {
+    TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+    TEveGeoManagerHolder holder(TEveGeoShape::GetGeoMangeur());
+    return new TGeoEltu(a, b, dz);
+}
+
+TGeoShape* CP::TShapeFactory::MakeSphere(double radius) {
+    TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+    TEveGeoManagerHolder holder(TEveGeoShape::GetGeoMangeur());
+    return new TGeoSphere(0.0, radius);
+}
+
+TGeoShape* CP::TShapeFactory::Clone(const TGeoShape* shape) {
+    if (!shape) return NULL;
+    TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+    TEveGeoManagerHolder holder(TEveGeoShape::GetGeoMangeur());
+    return dynamic_cast<TGeoShape*>(shape->Clone(shape->GetName()));
+}
+
+void CP::TShapeFactory::SetShape(TEveGeoShape* element, TGeoShape* shape) {
+    if (!element) return;
+    TLockGuard guard(&CP::TVEventChangeHandler::GetGeometryLock());
+    element->SetShape(shape);
+}
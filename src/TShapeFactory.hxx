@@ -0,0 +1,40 @@
+#ifndef TShapeFactory_hxx_seen
+#define TShapeFactory_hxx_seen
+
+namespace CP {
+    class TShapeFactory;
+};
+
+class TGeoShape;
+class TEveGeoShape;
+
+/// Create the TGeoShape objects shown by TEveGeoShape elements.  A TGeoShape
+/// registers itself with gGeoManager when it's created, so the shapes for
+/// Eve have to be made while gGeoManager points to the private geometry
+/// manager used by TEveGeoShape (TEveGeoShape::SetShape() does the same
+/// swap internally).  Changing gGeoManager while another thread is using the
+/// navigator (e.g. in CP::TVEventChangeHandler::Build()) gives the wrong
+/// answer, so every use of the factory holds the geometry lock (see
+/// CP::TVEventChangeHandler::GetGeometryLock()), which is the same lock that
+/// protects the navigator.  The Eve elements that use the factory for all
+/// of their shapes (e.g. CP::TMatrixElement and CP::TReconShowerElement)
+/// can then be built on any thread.
+class CP::TShapeFactory {
+public:
+    /// Make an elliptical tube with semi-axes a and b, and a half length of
+    /// dz.
+    static TGeoShape* MakeEltu(double a, double b, double dz);
+
+    /// Make a sphere.
+    static TGeoShape* MakeSphere(double radius);
+
+    /// Make a copy of a shape from the geometry (e.g. for the simplified
+    /// geometry).
+    static TGeoShape* Clone(const TGeoShape* shape);
+
+    /// Set the shape shown by an element.  The element takes a reference
+    /// to the shape, and the shape is deleted with the last element that
+    /// uses it.
+    static void SetShape(TEveGeoShape* element, TGeoShape* shape);
+};
+#endif
@@ -1,17 +1,26 @@
 #include <TShowDriftHits.hxx>
+#include "TEventDisplay.hxx"
+#include "TEvePool.hxx"
 
 #include <TEveManager.h>
 #include <TEveBoxSet.h>
 
-CP::TShowDriftHits::TShowDriftHits(double velocity) 
-    : fDriftVelocity(velocity) {}
+CP::TShowDriftHits::TShowDriftHits(double velocity, bool boxes) 
+    : fDriftVelocity(velocity), fBoxes(boxes) {}
 
 bool CP::TShowDriftHits::operator () (TEveElementList* elements, 
                                       const CP::THitSelection& hits,
                                       double t0) {
 
-    TEveBoxSet* boxes = new TEveBoxSet(hits.GetName());
-    boxes->Reset(TEveBoxSet::kBT_AABox, kTRUE, 128);
+    TEveBoxSet* boxes = CP::TEventDisplay::Get().Pool().Get<TEveBoxSet>();
+    boxes->SetName(hits.GetName());
+    if (!fBoxes) {
+        // Fixed size markers don't store a size for each hit.
+        boxes->Reset(TEveBoxSet::kBT_AABoxFixedDim, kTRUE, 128);
+        boxes->SetDefWidth(2*unit::mm);
+        boxes->SetDefHeight(2*unit::mm);
+        boxes->SetDefDepth(2*unit::mm);
+    }
 
     TVector3 pos; 
     TVector3 drift(0,0,fDriftVelocity);
@@ -22,6 +31,14 @@ bool CP::TShowDriftHits::operator () (TEveElementList* elements,
         // The value is the charge.
         double deltaT = (*h)->GetTime() - t0;
         pos = (*h)->GetPosition() - deltaT*drift;
+        if (!fBoxes) {
+            boxes->AddBox(pos.X()-1*unit::mm,
+                          pos.Y()-1*unit::mm,
+                          pos.Z()-1*unit::mm);
+            boxes->DigitValue((*h)->GetCharge());
+            boxes->DigitId(&(*(*h)));
+            continue;
+        }
         const TVector3& half = (*h)->GetRMS();
         boxes->AddBox(pos.X()-half.X(), 
                       pos.Y()-half.Y(), 
@@ -16,8 +16,11 @@ class CP::TShowDriftHits {
 public:
 
     /// Construct an object to show the hits using a drift velocity.  The
-    /// drift is assumed to be on the Z axis.
-    explicit TShowDriftHits(double velocity = 1.6*unit::mm/unit::microsecond);
+    /// drift is assumed to be on the Z axis.  If boxes is false, the hits
+    /// are shown as small fixed size markers instead of boxes with the size
+    /// of the hit RMS (which is much cheaper to draw for large events).
+    explicit TShowDriftHits(double velocity = 1.6*unit::mm/unit::microsecond,
+                            bool boxes = true);
 
     /// Show the hits in the selection using a particular t0.  The element
     /// list is mutated by adding elements that will actually show the hit
@@ -29,6 +32,9 @@ private:
 
     /// The drift velocity used to plot the hits.
     double fDriftVelocity;
+
+    /// Flag that the hits are drawn as boxes with the size of the hit RMS.
+    bool fBoxes;
 };
 #endif
 
@@ -1,4 +1,6 @@
 #include <TShowPMTHits.hxx>
+#include "TEventDisplay.hxx"
+#include "TEvePool.hxx"
 
 #include <THitSelection.hxx>
 #include <THit.hxx>
@@ -15,9 +17,15 @@ CP::TShowPMTHits::TShowPMTHits(TEveRGBAPalette* palette)
 
 bool CP::TShowPMTHits::operator () (TEveElementList* elements, 
                                     const CP::THitSelection& hits) {
-    
-    TEveBoxSet* boxes = new TEveBoxSet(hits.GetName());
-    boxes->Reset(TEveBoxSet::kBT_AABox, kTRUE, 128);
+    std::vector<Box> boxes;
+    MakeBoxes(hits, boxes);
+    AddBoxes(elements, hits.GetName(), boxes);
+    return true;
+}
+
+void CP::TShowPMTHits::MakeBoxes(const CP::THitSelection& hits,
+                                 std::vector<Box>& boxes) {
+    boxes.clear();
 
     std::map<CP::TGeometryId, double > hitCharges;
     std::map<CP::TGeometryId, CP::THandle<CP::THit> > firstHits;
@@ -44,17 +52,29 @@ bool CP::TShowPMTHits::operator () (TEveElementList* elements,
         double zHalf = 5*(1.0+9.0*std::log(1.0+charge)/std::log(10.0))*unit::mm;
         double top = 0.0;
         if (pos.Z() < -10*unit::cm) top = -1;
-        boxes->AddBox(pos.X()-xyHalf, 
-                      pos.Y()-xyHalf, 
-                      pos.Z()+2*top*zHalf,
-                      2*xyHalf, 
-                      2*xyHalf,
-                      2*zHalf);
-        boxes->DigitValue(charge);
+        Box box;
+        box.x = pos.X()-xyHalf;
+        box.y = pos.Y()-xyHalf;
+        box.z = pos.Z()+2*top*zHalf;
+        box.dx = 2*xyHalf;
+        box.dy = 2*xyHalf;
+        box.dz = 2*zHalf;
+        box.charge = charge;
+        boxes.push_back(box);
     }
-    boxes->RefitPlex();
-    
-    elements->AddElement(boxes);
+}
 
-    return true;
+void CP::TShowPMTHits::AddBoxes(TEveElementList* elements,
+                                const std::string& name,
+                                const std::vector<Box>& boxes) {
+    TEveBoxSet* boxSet = CP::TEventDisplay::Get().Pool().Get<TEveBoxSet>();
+    boxSet->SetName(name.c_str());
+    for (std::vector<Box>::const_iterator b = boxes.begin();
+         b != boxes.end(); ++b) {
+        boxSet->AddBox(b->x, b->y, b->z, b->dx, b->dy, b->dz);
+        boxSet->DigitValue(b->charge);
+    }
+    boxSet->RefitPlex();
+    
+    elements->AddElement(boxSet);
 }
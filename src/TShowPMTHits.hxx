@@ -4,6 +4,9 @@
 #include <THitSelection.hxx>
 #include <HEPUnits.hxx>
 
+#include <string>
+#include <vector>
+
 namespace CP {
     class TShowPMTHits;
 };
@@ -24,6 +27,23 @@ public:
     /// (nominally, this adds a box set).
     bool operator () (TEveElementList* elements, 
                       const CP::THitSelection& hits);
+
+    /// The box drawn for a PMT.  The position is the low corner.
+    struct Box {
+        float x, y, z;
+        float dx, dy, dz;
+        float charge;
+    };
+
+    /// Fill the boxes for the PMT hits in the selection.  This doesn't
+    /// touch Eve, so it can be used on a worker thread.
+    static void MakeBoxes(const CP::THitSelection& hits,
+                          std::vector<Box>& boxes);
+
+    /// Add a box set with the boxes to the element list.
+    void AddBoxes(TEveElementList* elements, const std::string& name,
+                  const std::vector<Box>& boxes);
+
 private:
 
     /// The palette to draw with.
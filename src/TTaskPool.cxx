@@ -0,0 +1,219 @@
+#include "TTaskPool.hxx"
+#include "TVTask.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <TThread.h>
+#include <TStopwatch.h>
+#include <TSystem.h>
+#include <TVirtualMutex.h>
+
+#include <algorithm>
+
+CP::TTaskPool::TTaskPool(int threads)
+    : fLock(kTRUE), fWake(&fLock), fQueued(0), fStop(false),
+      fTimingLock(kTRUE) {
+    if (threads < 1) {
+        SysInfo_t info;
+        if (gSystem->GetSysInfo(&info) == 0) threads = info.fCpus;
+        threads = std::max(1,threads);
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        fQueues.push_back(new Queue);
+        fThreadIds.push_back(0);
+    }
+
+    if (threads > 1) TThread::Initialize();
+    fThreadArgs.resize(threads);
+    for (int i = 1; i < threads; ++i) {
+        fThreadArgs[i].pool = this;
+        fThreadArgs[i].queue = i;
+        TThread* thread = new TThread("taskPool",
+                                      &CP::TTaskPool::ThreadFunction,
+                                      &fThreadArgs[i]);
+        fThreads.push_back(thread);
+        thread->Run();
+    }
+
+    CaptLog("Task pool with " << threads << " threads");
+}
+
+CP::TTaskPool::~TTaskPool() {
+    fLock.Lock();
+    fStop = true;
+    fWake.Broadcast();
+    fLock.UnLock();
+    for (std::vector<TThread*>::iterator t = fThreads.begin();
+         t != fThreads.end(); ++t) {
+        (*t)->Join();
+        delete (*t);
+    }
+    for (std::vector<Queue*>::iterator q = fQueues.begin();
+         q != fQueues.end(); ++q) {
+        for (std::deque<Entry>::iterator e = (*q)->tasks.begin();
+             e != (*q)->tasks.end(); ++e) {
+            delete e->task;
+        }
+        delete (*q);
+    }
+}
+
+void CP::TTaskPool::Submit(CP::TVTask* task, Group& group) {
+    if (!task) return;
+    {
+        TLockGuard guard(&fLock);
+        ++group.fPending;
+        ++group.fSubmitted;
+        ++fQueued;
+    }
+    task->fGroup = &group;
+    Entry entry;
+    entry.task = task;
+    entry.group = &group;
+    Queue* queue = fQueues[GetQueueIndex()];
+    {
+        TLockGuard guard(&queue->lock);
+        queue->tasks.push_back(entry);
+    }
+    TLockGuard guard(&fLock);
+    fWake.Signal();
+}
+
+void CP::TTaskPool::Wait(Group& group) {
+    int queue = GetQueueIndex();
+    while (true) {
+        {
+            TLockGuard guard(&fLock);
+            if (group.fPending < 1) return;
+        }
+        if (RunOneTask(queue)) continue;
+        // Nothing left to run, so the tasks in the group are running on
+        // other threads.
+        TLockGuard guard(&fLock);
+        if (group.fPending < 1) return;
+        fWake.TimedWaitRelative(1);
+    }
+}
+
+void CP::TTaskPool::Cancel(Group& group) {
+    TLockGuard guard(&fLock);
+    group.fCancelled = true;
+}
+
+bool CP::TTaskPool::IsDone(Group& group) {
+    TLockGuard guard(&fLock);
+    return (group.fPending < 1);
+}
+
+void CP::TTaskPool::GetProgress(Group& group, int& finished, int& submitted) {
+    TLockGuard guard(&fLock);
+    submitted = group.fSubmitted;
+    finished = group.fSubmitted - group.fPending;
+}
+
+bool CP::TTaskPool::RunOne() {
+    return RunOneTask(GetQueueIndex());
+}
+
+std::map<std::string,CP::TTaskPool::Timing> CP::TTaskPool::GetTiming() {
+    TLockGuard guard(&fTimingLock);
+    return fTiming;
+}
+
+void CP::TTaskPool::ResetTiming() {
+    TLockGuard guard(&fTimingLock);
+    fTiming.clear();
+}
+
+void CP::TTaskPool::PrintTiming() {
+    std::map<std::string,Timing> timing = GetTiming();
+    for (std::map<std::string,Timing>::iterator t = timing.begin();
+         t != timing.end(); ++t) {
+        CaptInfo("Task " << t->first << ": " << t->second.count << " runs, "
+                 << 1000.0*t->second.total/std::max(1,t->second.count)
+                 << " ms average, "
+                 << 1000.0*t->second.maximum << " ms maximum");
+    }
+}
+
+void* CP::TTaskPool::ThreadFunction(void* arg) {
+    ThreadArg* threadArg = static_cast<ThreadArg*>(arg);
+    threadArg->pool->Run(threadArg->queue);
+    return NULL;
+}
+
+void CP::TTaskPool::Run(int queue) {
+    {
+        TLockGuard guard(&fLock);
+        fThreadIds[queue] = TThread::SelfId();
+    }
+    while (true) {
+        if (RunOneTask(queue)) continue;
+        TLockGuard guard(&fLock);
+        if (fStop) return;
+        if (fQueued < 1) fWake.TimedWaitRelative(10);
+    }
+}
+
+bool CP::TTaskPool::RunOneTask(int queue) {
+    Entry entry;
+    entry.task = NULL;
+
+    // Take the newest task from this thread's queue.
+    {
+        Queue* own = fQueues[queue];
+        TLockGuard guard(&own->lock);
+        if (!own->tasks.empty()) {
+            entry = own->tasks.back();
+            own->tasks.pop_back();
+        }
+    }
+
+    // Steal the oldest task from another queue.
+    for (std::size_t i = 1; !entry.task && i < fQueues.size(); ++i) {
+        Queue* other = fQueues[(queue + i) % fQueues.size()];
+        TLockGuard guard(&other->lock);
+        if (!other->tasks.empty()) {
+            entry = other->tasks.front();
+            other->tasks.pop_front();
+        }
+    }
+
+    if (!entry.task) return false;
+
+    {
+        TLockGuard guard(&fLock);
+        --fQueued;
+    }
+
+    // The tasks of a cancelled group are dropped without being run.
+    if (!entry.group->fCancelled) {
+        TStopwatch timer;
+        timer.Start();
+        entry.task->Execute();
+        timer.Stop();
+
+        TLockGuard guard(&fTimingLock);
+        Timing& timing = fTiming[entry.task->GetName()];
+        ++timing.count;
+        timing.total += timer.RealTime();
+        timing.maximum = std::max(timing.maximum, timer.RealTime());
+    }
+
+    delete entry.task;
+
+    TLockGuard guard(&fLock);
+    --entry.group->fPending;
+    fWake.Broadcast();
+    return true;
+}
+
+int CP::TTaskPool::GetQueueIndex() {
+    Long_t self = TThread::SelfId();
+    TLockGuard guard(&fLock);
+    for (std::size_t i = 1; i < fThreadIds.size(); ++i) {
+        if (fThreadIds[i] == self) return i;
+    }
+    return 0;
+}
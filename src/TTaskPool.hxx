@@ -0,0 +1,180 @@
+#ifndef TTaskPool_hxx_seen
+#define TTaskPool_hxx_seen
+
+#include <TMutex.h>
+#include <TCondition.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TTaskPool;
+    class TVTask;
+};
+
+class TThread;
+
+/// A small work stealing pool of threads to run CP::TVTask objects.  Each
+/// thread has its own queue of tasks.  A thread runs the newest task from
+/// its own queue, and when its queue is empty it steals the oldest task from
+/// another queue.  Tasks submitted by a task go on the queue of the thread
+/// running it, so nested work (e.g. the chunks of a digit plot submitted by
+/// the task that splits the plot) stays on the same thread unless another
+/// thread is idle.  A thread that
+/// waits for a group of tasks runs queued tasks while it waits, so a task
+/// can wait for its own subtasks without tying up a thread.
+///
+/// A group of tasks can be cancelled (e.g. when the user moves to another
+/// event while it is being drawn).  The tasks of a cancelled group that
+/// haven't started are deleted without being run, and the running tasks can
+/// check TVTask::IsCancelled() to stop early.
+///
+/// The time taken by each task is collected by task name (see
+/// TVTask::GetName()).  The pool is owned by CP::TEventDisplay and is
+/// accessed through CP::TEventDisplay::Tasks().
+class CP::TTaskPool {
+public:
+    /// Create a pool with "threads" threads, including the thread that waits
+    /// for the tasks (so a pool with one thread runs the tasks on the
+    /// waiting thread).  If threads is less than one, a thread is used for
+    /// each CPU.
+    explicit TTaskPool(int threads);
+    ~TTaskPool();
+
+    /// A set of tasks that can be waited for.
+    class Group {
+    public:
+        Group() : fPending(0), fSubmitted(0), fCancelled(false) {}
+
+        /// Check if the group has been cancelled.
+        bool IsCancelled() const {return fCancelled;}
+
+    private:
+        friend class CP::TTaskPool;
+        /// The number of tasks that haven't finished.
+        int fPending;
+        /// The number of tasks that have been submitted.
+        int fSubmitted;
+        /// A flag that the group has been cancelled.  This is only set by
+        /// Cancel(), and is read without the lock by the running tasks.
+        volatile bool fCancelled;
+    };
+
+    /// The timing collected for tasks with the same name.
+    struct Timing {
+        Timing() : count(0), total(0.0), maximum(0.0) {}
+        /// The number of tasks that have run.
+        int count;
+        /// The total time (in seconds) for the tasks.
+        double total;
+        /// The longest time (in seconds) for a task.
+        double maximum;
+    };
+
+    /// Add a task to the group and queue it to be run.  The pool takes
+    /// ownership of the task and deletes it after it has run.
+    void Submit(CP::TVTask* task, Group& group);
+
+    /// Wait for all of the tasks in the group to finish.  The calling thread
+    /// runs queued tasks while it waits.
+    void Wait(Group& group);
+
+    /// Cancel the tasks in the group.  The tasks that haven't started are
+    /// deleted without being run.  This doesn't wait for the running tasks,
+    /// so Wait() must still be called before the group is deleted.
+    void Cancel(Group& group);
+
+    /// Check if all of the tasks in the group have finished.  This doesn't
+    /// block, so it can be used by a GUI timer.
+    bool IsDone(Group& group);
+
+    /// Get the number of tasks in the group that have finished, and the
+    /// number that have been submitted.
+    void GetProgress(Group& group, int& finished, int& submitted);
+
+    /// Run one queued task on the calling thread, and return false if there
+    /// wasn't a task to run.  This lets the main thread make progress in
+    /// small steps (e.g. from a GUI timer) when the pool doesn't have any
+    /// threads of its own.
+    bool RunOne();
+
+    /// Get the number of threads (including the waiting thread).
+    int GetThreadCount() const {return fQueues.size();}
+
+    /// Get a copy of the task timing indexed by task name.
+    std::map<std::string,Timing> GetTiming();
+
+    /// Clear the task timing.
+    void ResetTiming();
+
+    /// Print the task timing to the log.
+    void PrintTiming();
+
+private:
+    /// A queued task and the group it belongs to.
+    struct Entry {
+        CP::TVTask* task;
+        Group* group;
+    };
+
+    /// The queue of tasks for one thread.
+    struct Queue {
+        Queue() : lock(kTRUE) {}
+        std::deque<Entry> tasks;
+        TMutex lock;
+    };
+
+    /// The argument passed to a pool thread.
+    struct ThreadArg {
+        CP::TTaskPool* pool;
+        int queue;
+    };
+
+    /// The function run by the pool threads.
+    static void* ThreadFunction(void* arg);
+
+    /// The worker loop for the pool thread using a queue.
+    void Run(int queue);
+
+    /// Run one task from the queue, or steal one from another queue.  This
+    /// returns false if there wasn't a task to run.
+    bool RunOneTask(int queue);
+
+    /// Get the queue used by the calling thread.  Threads that don't belong
+    /// to the pool use the first queue.
+    int GetQueueIndex();
+
+    /// The task queues.  The first queue is used by threads that don't
+    /// belong to the pool.
+    std::vector<Queue*> fQueues;
+
+    /// The pool threads.  The thread for queue "i" is at "i-1".
+    std::vector<TThread*> fThreads;
+
+    /// The arguments for the pool threads.
+    std::vector<ThreadArg> fThreadArgs;
+
+    /// The thread ids of the pool threads, indexed by queue.
+    std::vector<Long_t> fThreadIds;
+
+    /// The lock protecting the counters and the group pending counts.
+    TMutex fLock;
+
+    /// Signaled when a task is queued or finished.
+    TCondition fWake;
+
+    /// The number of queued tasks.
+    int fQueued;
+
+    /// A flag to tell the pool threads to stop.
+    bool fStop;
+
+    /// The lock protecting the timing.
+    TMutex fTimingLock;
+
+    /// The timing collected for each task name.
+    std::map<std::string,Timing> fTiming;
+};
+#endif
@@ -0,0 +1,162 @@
+#include "TTimingTable.hxx"
+
+#include <TCaptLog.hxx>
+
+#include <TTimeStamp.h>
+#include <TVirtualMutex.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+CP::TTimingTable* CP::TTimingTable::fActive = NULL;
+
+CP::TTimingTable::TTimingTable(int history)
+    : fHistory(std::max(1,history)), fLock(kTRUE) {
+    fCurrent.entry = -1;
+}
+
+CP::TTimingTable::~TTimingTable() {
+    {
+        TLockGuard guard(&GetActiveLock());
+        if (fActive == this) fActive = NULL;
+    }
+    // Write the event that was being timed, since it's never finished by
+    // StartEvent().
+    TLockGuard guard(&fLock);
+    if (fCSVFile.is_open()) {
+        WriteRows(fCSVFile, fCurrent);
+        fCSVFile.close();
+    }
+}
+
+TMutex& CP::TTimingTable::GetActiveLock() {
+    static TMutex activeLock(kTRUE);
+    return activeLock;
+}
+
+CP::TTimingTable* CP::TTimingTable::GetActive() {
+    TLockGuard guard(&GetActiveLock());
+    return fActive;
+}
+
+double CP::TTimingTable::GetTime() {
+    TTimeStamp now;
+    return now.AsDouble();
+}
+
+void CP::TTimingTable::SetEnabled(bool enabled) {
+    TLockGuard guard(&GetActiveLock());
+    if (enabled) fActive = this;
+    else if (fActive == this) fActive = NULL;
+}
+
+void CP::TTimingTable::Add(const std::string& name, double seconds) {
+    TLockGuard guard(&fLock);
+    for (std::vector<Row>::iterator r = fCurrent.rows.begin();
+         r != fCurrent.rows.end(); ++r) {
+        if (r->name != name) continue;
+        r->seconds += seconds;
+        return;
+    }
+    Row row;
+    row.name = name;
+    row.seconds = seconds;
+    fCurrent.rows.push_back(row);
+}
+
+void CP::TTimingTable::StartEvent(int entry) {
+    TLockGuard guard(&fLock);
+    if (!fCurrent.rows.empty()) {
+        if (fCSVFile.is_open()) {
+            WriteRows(fCSVFile, fCurrent);
+            fCSVFile.flush();
+        }
+        fEvents.push_back(fCurrent);
+        while ((int) fEvents.size() > fHistory) fEvents.pop_front();
+    }
+    fCurrent.entry = entry;
+    fCurrent.rows.clear();
+}
+
+void CP::TTimingTable::SetCSVFile(const std::string& fileName) {
+    TLockGuard guard(&fLock);
+    if (fCSVFile.is_open()) fCSVFile.close();
+    if (fileName.empty()) return;
+    fCSVFile.open(fileName.c_str(), std::ios::out | std::ios::app);
+    if (!fCSVFile.is_open()) {
+        CaptError("Unable to open timing file " << fileName);
+        return;
+    }
+    fCSVFile.seekp(0, std::ios::end);
+    if (fCSVFile.tellp() == std::streampos(0)) {
+        fCSVFile << "entry,name,milliseconds" << std::endl;
+    }
+}
+
+bool CP::TTimingTable::WriteCSV(const std::string& fileName) {
+    std::ofstream output(fileName.c_str());
+    if (!output.is_open()) {
+        CaptError("Unable to write timing file " << fileName);
+        return false;
+    }
+    TLockGuard guard(&fLock);
+    output << "entry,name,milliseconds" << std::endl;
+    for (std::deque<Event>::iterator e = fEvents.begin();
+         e != fEvents.end(); ++e) {
+        WriteRows(output, *e);
+    }
+    WriteRows(output, fCurrent);
+    CaptLog("Timing for " << fEvents.size() + 1 << " events written to "
+            << fileName);
+    return true;
+}
+
+void CP::TTimingTable::GetSummary(std::vector<std::string>& lines) {
+    TLockGuard guard(&fLock);
+
+    // Collect the mean and maximum over the table for each timer, keeping
+    // the timers in the order they were first seen.
+    std::vector<std::string> names;
+    std::map<std::string, double> sums;
+    std::map<std::string, double> maxima;
+    std::map<std::string, int> counts;
+    for (std::size_t i = 0; i <= fEvents.size(); ++i) {
+        const Event& event = (i < fEvents.size()) ? fEvents[i] : fCurrent;
+        for (std::vector<Row>::const_iterator r = event.rows.begin();
+             r != event.rows.end(); ++r) {
+            if (counts.find(r->name) == counts.end()) {
+                names.push_back(r->name);
+            }
+            sums[r->name] += r->seconds;
+            maxima[r->name] = std::max(maxima[r->name], r->seconds);
+            ++counts[r->name];
+        }
+    }
+
+    std::map<std::string, double> current;
+    for (std::vector<Row>::const_iterator r = fCurrent.rows.begin();
+         r != fCurrent.rows.end(); ++r) {
+        current[r->name] = r->seconds;
+    }
+
+    for (std::vector<std::string>::iterator n = names.begin();
+         n != names.end(); ++n) {
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1)
+             << *n << ": "
+             << 1000.0*current[*n] << " ms (mean "
+             << 1000.0*sums[*n]/counts[*n] << ", max "
+             << 1000.0*maxima[*n] << ")";
+        lines.push_back(line.str());
+    }
+}
+
+void CP::TTimingTable::WriteRows(std::ostream& output, const Event& event) {
+    for (std::vector<Row>::const_iterator r = event.rows.begin();
+         r != event.rows.end(); ++r) {
+        output << event.entry << "," << r->name << ","
+               << 1000.0*r->seconds << std::endl;
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef TTimingTable_hxx_seen
+#define TTimingTable_hxx_seen
+
+#include <TMutex.h>
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TTimingTable;
+};
+
+/// A table of the time spent in each part of the display (reading the event,
+/// each event change handler, the plots, and the final redraw) for the
+/// recently viewed events.  The times are measured by CP::TScopedTimer
+/// objects, which only take a lock to check if the table is enabled when
+/// timing is off, so the timers are always compiled in.  The times for an
+/// event are collected from when it is started with StartEvent() until the
+/// next event is started, and a time measured more than once for an event
+/// (e.g. a subtask) is summed.  The table keeps the times for a fixed number
+/// of events, and they can be written as CSV with one row per event and
+/// timer.  The table is owned by CP::TEventDisplay and is accessed through
+/// CP::TEventDisplay::Timing().
+class CP::TTimingTable {
+public:
+    /// Create a table that keeps the times for "history" events.
+    explicit TTimingTable(int history);
+    ~TTimingTable();
+
+    /// Get the table if timing is enabled, otherwise this returns NULL.
+    /// This is used by CP::TScopedTimer so the timers cost almost nothing
+    /// when timing is disabled.  The timers run on the task pool threads, so
+    /// the enabled table is read while holding a lock.
+    static CP::TTimingTable* GetActive();
+
+    /// Get the current time in seconds.
+    static double GetTime();
+
+    /// Enable (or disable) the timing.
+    void SetEnabled(bool enabled);
+
+    /// Check if the timing is enabled.
+    bool IsEnabled() const {return GetActive() == this;}
+
+    /// Add a time (in seconds) to the current event.  This is thread safe.
+    void Add(const std::string& name, double seconds);
+
+    /// Start collecting the times for an entry.  The times for the last
+    /// entry are moved into the history (and written to the CSV file if it
+    /// is open).
+    void StartEvent(int entry);
+
+    /// Append the times for each event to a CSV file as the events are
+    /// finished.  The header is only written when the file is new (or
+    /// empty), so several sessions can be collected in one file.  An empty
+    /// file name closes the file.
+    void SetCSVFile(const std::string& fileName);
+
+    /// Write the times for all of the events in the table to a CSV file.
+    /// This returns false if the file can't be written.
+    bool WriteCSV(const std::string& fileName);
+
+    /// Get a line of text for each timer summarizing the time for the
+    /// current event, and the mean and maximum over the events in the
+    /// table.
+    void GetSummary(std::vector<std::string>& lines);
+
+private:
+    /// The time for a timer during an event.
+    struct Row {
+        std::string name;
+        double seconds;
+    };
+
+    /// The times for one event.
+    struct Event {
+        int entry;
+        std::vector<Row> rows;
+    };
+
+    /// Write the rows for an event to a CSV stream.
+    static void WriteRows(std::ostream& output, const Event& event);
+
+    /// Get the lock protecting fActive.
+    static TMutex& GetActiveLock();
+
+    /// The enabled table (or NULL).  This is protected by GetActiveLock().
+    static CP::TTimingTable* fActive;
+
+    /// The number of events kept.
+    int fHistory;
+
+    /// The event being timed.
+    Event fCurrent;
+
+    /// The finished events with the oldest first.
+    std::deque<Event> fEvents;
+
+    /// The file that finished events are written to.
+    std::ofstream fCSVFile;
+
+    /// The lock protecting the table.
+    TMutex fLock;
+};
+#endif
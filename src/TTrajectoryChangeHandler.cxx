@@ -1,6 +1,7 @@
 #include "TTrajectoryChangeHandler.hxx"
 #include "TEventDisplay.hxx"
 #include "TGUIManager.hxx"
+#include "TEvePool.hxx"
 
 #include <TCaptLog.hxx>
 #include <TG4Trajectory.hxx>
@@ -10,7 +11,6 @@
 #include <HEPUnits.hxx>
 #include <THandle.hxx>
 
-#include <TGeoManager.h>
 #include <TGButton.h>
 
 #include <TEveManager.h>
@@ -18,7 +18,9 @@
 
 #include <sstream>
 
-CP::TTrajectoryChangeHandler::TTrajectoryChangeHandler() {
+CP::TTrajectoryChangeHandler::TTrajectoryChangeHandler()
+    : fShowTrajectories(false), fFoundTrajectories(false),
+      fFoundLiquid(false) {
     fTrajectoryList = new TEveElementList("g4Trajectories",
                                           "Geant4 Trajectories");
     fTrajectoryList->SetMainColor(kYellow);
@@ -29,30 +31,42 @@ CP::TTrajectoryChangeHandler::TTrajectoryChangeHandler() {
 CP::TTrajectoryChangeHandler::~TTrajectoryChangeHandler() {
 }
 
-void CP::TTrajectoryChangeHandler::Apply() {
-
-    fTrajectoryList->DestroyElements();
-
+void CP::TTrajectoryChangeHandler::AddEventPaths(
+    std::vector<std::string>& paths) {
     if (!CP::TEventDisplay::Get().GUI().GetShowTrajectoriesButton()->IsOn()) {
-        CaptLog("Trajectories disabled");
         return;
     }
+    paths.push_back("truth/G4Trajectories");
+}
 
-    CaptLog("Handle the trajectories");
-    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
-    if (!event) return;
+bool CP::TTrajectoryChangeHandler::AddInputs(std::ostream& inputs) {
+    inputs << CP::TEventDisplay::Get().GUI()
+        .GetShowTrajectoriesButton()->IsOn();
+    return true;
+}
+
+void CP::TTrajectoryChangeHandler::Prepare() {
+    fShowTrajectories
+        = CP::TEventDisplay::Get().GUI().GetShowTrajectoriesButton()->IsOn();
+    fFoundTrajectories = false;
+    fLines.clear();
+    if (!fShowTrajectories) return;
+    fFoundLiquid
+        = fLiquid.Update(CP::TEventDisplay::Get().GetGeometrySerial());
+}
+
+void CP::TTrajectoryChangeHandler::Build(CP::TEvent& event) {
+    if (!fShowTrajectories) return;
 
     CP::THandle<CP::TG4TrajectoryContainer> trajectories
-        = event->Get<CP::TG4TrajectoryContainer>("truth/G4Trajectories");
-    
-    if (!trajectories) {
-        CaptLog("No trajectories in event");
-        return;
-    }
+        = event.Get<CP::TG4TrajectoryContainer>("truth/G4Trajectories");
+    if (!trajectories) return;
+    fFoundTrajectories = true;
 
     for (CP::TG4TrajectoryContainer::iterator tPair = trajectories->begin();
          tPair != trajectories->end();
          ++tPair) {
+        if (IsCancelled()) return;
         CP::TG4Trajectory& traj = tPair->second;
         const CP::TG4Trajectory::Points& points = traj.GetTrajectoryPoints();
         const TParticlePDG *pdg = traj.GetParticle();
@@ -66,30 +80,72 @@ void CP::TTrajectoryChangeHandler::Apply() {
         label << traj.GetParticleName() 
               << " (" << traj.GetInitialMomentum().E()/unit::MeV << " MeV)";
 
-        TEveLine *track = new TEveLine();
-        track->SetName("trajectory");
-        track->SetTitle(label.str().c_str());
+        Line proto;
+        proto.title = label.str();
         if (charged) {
-            track->SetLineColor(kYellow);
-            track->SetLineStyle(3);
+            proto.color = kYellow;
+            proto.style = 3;
         }
         else {
-            track->SetLineColor(kYellow+4);
-            track->SetLineStyle(4);
+            proto.color = kYellow+4;
+            proto.style = 4;
         }
 
+        // Clip the trajectory to the liquid.  A step that crosses the
+        // boundary is cut where it crosses, and a new line is started each
+        // time the trajectory enters the liquid.
+        std::size_t line = fLines.size();
+        bool lastInside = false;
+        TVector3 last;
         for (std::size_t p = 0; p < points.size(); ++p) {
-            gGeoManager->PushPath();
-            gGeoManager->FindNode(points[p].GetPosition().X(),
-                                  points[p].GetPosition().Y(),
-                                  points[p].GetPosition().Z());
-            std::string path(gGeoManager->GetPath());
-            gGeoManager->PopPath();
-            if (path.find("/Liquid_") == std::string::npos) continue;
-            track->SetPoint(p, 
-                            points[p].GetPosition().X(),
-                            points[p].GetPosition().Y(),
-                            points[p].GetPosition().Z());
+            TVector3 pos = points[p].GetPosition().Vect();
+            bool inside = !fFoundLiquid || fLiquid.Contains(pos);
+            if (p > 0 && lastInside && !inside) {
+                fLines[line].points.push_back(
+                    fLiquid.FindBoundary(last, pos));
+            }
+            else if (inside && !lastInside) {
+                line = fLines.size();
+                fLines.push_back(proto);
+                if (p > 0) {
+                    fLines[line].points.push_back(
+                        fLiquid.FindBoundary(pos, last));
+                }
+            }
+            if (inside) fLines[line].points.push_back(pos);
+            last = pos;
+            lastInside = inside;
+        }
+    }
+}
+
+void CP::TTrajectoryChangeHandler::Commit() {
+
+    CP::TEventDisplay::Get().Pool().Release(fTrajectoryList);
+
+    if (!fShowTrajectories) {
+        CaptLog("Trajectories disabled");
+        return;
+    }
+
+    CaptLog("Handle the trajectories");
+    if (!fFoundTrajectories) {
+        CaptLog("No trajectories in event");
+        return;
+    }
+
+    for (std::vector<Line>::iterator line = fLines.begin();
+         line != fLines.end(); ++line) {
+        TEveLine *track = CP::TEventDisplay::Get().Pool().Get<TEveLine>();
+        track->SetName("trajectory");
+        track->SetTitle(line->title.c_str());
+        track->SetLineColor(line->color);
+        track->SetLineStyle(line->style);
+        for (std::size_t p = 0; p < line->points.size(); ++p) {
+            track->SetPoint(p,
+                            line->points[p].X(),
+                            line->points[p].Y(),
+                            line->points[p].Z());
         }
         fTrajectoryList->AddElement(track);
     }
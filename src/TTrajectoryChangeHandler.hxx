@@ -2,6 +2,12 @@
 #define TTrajectoryChangeHandler_hxx_seen
 
 #include "TVEventChangeHandler.hxx"
+#include "TLiquidVolume.hxx"
+
+#include <TVector3.h>
+
+#include <string>
+#include <vector>
 
 namespace CP {
     class TTrajectoryChangeHandler;
@@ -15,14 +21,61 @@ public:
     TTrajectoryChangeHandler();
     ~TTrajectoryChangeHandler();
 
+    /// The name used for the timing of the build.
+    virtual const char* GetName() const {return "TTrajectoryChangeHandler";}
+
+    /// The trajectories are built on a worker thread.
+    virtual bool IsTwoPhase() const {return true;}
+
+    /// Copy the GUI settings, and find the liquid volume if the geometry has
+    /// changed.
+    virtual void Prepare();
+
+    /// Compute the lines for the trajectories in the event.
+    virtual void Build(CP::TEvent& event);
+
     /// Draw the trajectories into the current scene.
-   virtual void Apply();
+    virtual void Commit();
+
+    /// Add the state of the "Show Trajectories" button.
+    virtual bool AddInputs(std::ostream& inputs);
+
+    /// Add the event paths read by Build().
+    virtual void AddEventPaths(std::vector<std::string>& paths);
 
 private:
 
+    /// The line drawn for a part of a trajectory inside the liquid.  A
+    /// trajectory that leaves the liquid and comes back is drawn with more
+    /// than one line.
+    struct Line {
+        std::string title;
+        int color;
+        int style;
+        /// The trajectory points inside the liquid.  The first and last
+        /// points are on the boundary if the trajectory crosses it.
+        std::vector<TVector3> points;
+    };
+
     /// The trajectories to draw in the event.
     TEveElementList* fTrajectoryList;
 
+    /// A boolean to flag if the trajectories should be drawn.
+    bool fShowTrajectories;
+
+    /// A boolean to flag if the event has trajectories.
+    bool fFoundTrajectories;
+
+    /// The lines made by Build().
+    std::vector<Line> fLines;
+
+    /// The test for points in the liquid.
+    CP::TLiquidVolume fLiquid;
+
+    /// A boolean to flag if the liquid was found.  When there isn't any
+    /// liquid (e.g. without a geometry) the whole trajectory is drawn.
+    bool fFoundLiquid;
+
 };
 
 #endif
@@ -0,0 +1,18 @@
+#include "TVEventChangeHandler.hxx"
+
+#include <TEvent.hxx>
+#include <TEventFolder.hxx>
+
+#include <TMutex.h>
+
+void CP::TVEventChangeHandler::Apply() {
+    Prepare();
+    CP::TEvent* event = CP::TEventFolder::GetCurrentEvent();
+    if (event) Build(*event);
+    Commit();
+}
+
+TMutex& CP::TVEventChangeHandler::GetGeometryLock() {
+    static TMutex geometryLock(kTRUE);
+    return geometryLock;
+}
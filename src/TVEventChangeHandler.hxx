@@ -1,24 +1,112 @@
 #ifndef TVEventChangeHandler_hxx_seen
 #define TVEventChangeHandler_hxx_seen
 
+#include "TTaskPool.hxx"
+
 #include <TObject.h>
 
+#include <ostream>
+#include <string>
+#include <vector>
+
 namespace CP {
     class TVEventChangeHandler;
+    class TEvent;
 };
 
+class TMutex;
+
 /// A base class for handlers called by TEventChangeManager.  The
 /// TEventChangeManager keeps a vector of possible handlers that are used
 /// everytime the event has changed (or needs to be reset).  The handlers need
 /// to implement the XXX class, and should check to see if they are enabled
 /// using the GUI class.
+///
+/// A handler can either do all of the work in Apply(), or split the work
+/// into phases so that the slow part can run on a worker thread.  A handler
+/// that is split returns true from IsTwoPhase(), and the
+/// TEventChangeManager then calls
+///
+/// - Prepare() : On the main thread to copy the GUI settings.
+/// - Build()   : On a worker thread (at the same time as the Build() of the
+///               other handlers) to compute what will be drawn from the
+///               event.  The result is saved as plain data in the handler.
+/// - Commit()  : On the main thread to turn the plain data into Eve
+///               elements.
 class CP::TVEventChangeHandler: public TObject {
 public:
-    TVEventChangeHandler() {}
+    TVEventChangeHandler() : fBuildGroup(NULL) {}
     virtual ~TVEventChangeHandler() {}
 
     /// Apply the change handler to the current event.  This does all of the
-    /// work.
-    virtual void Apply() = 0;
+    /// work.  The default runs Prepare(), Build() and Commit() on the
+    /// current thread.
+    virtual void Apply();
+
+    /// Return true if the handler implements Prepare(), Build() and
+    /// Commit() so that Build() can be run on a worker thread.
+    virtual bool IsTwoPhase() const {return false;}
+
+    /// Copy the GUI settings needed by Build().  This is called on the main
+    /// thread.
+    virtual void Prepare() {}
+
+    /// Compute what will be drawn for the event and save it as plain data.
+    /// This is run as a task in the CP::TTaskPool (see
+    /// CP::TEventDisplay::Tasks()) while the GUI keeps running.  The event
+    /// won't change since the TEventChangeManager cancels the update (see
+    /// IsCancelled()) before it replaces the current event.
+    /// Nested work can be split into subtasks submitted to the same pool.
+    /// It must only read the folders that the handler asks for in
+    /// AddEventPaths(), and must not use the GUI, gEve, or the
+    /// CP::TEventFolder.  Any use of gGeoManager must be protected by
+    /// GetGeometryLock().
+    virtual void Build(CP::TEvent& event) {}
+
+    /// Turn the data saved by Build() into Eve elements.  This is called on
+    /// the main thread, and should be short.
+    virtual void Commit() {}
+
+    /// Add the event paths (e.g. "~/hits/drift") read by Apply(), or by
+    /// Prepare() and Build(), with the current GUI settings.  Folders that
+    /// no handler asks for may be removed from the events held in memory,
+    /// and are read again when a handler asks for them.  The default is to
+    /// ask for the whole event ("~"), so handlers should override this with
+    /// the folders they actually read.
+    virtual void AddEventPaths(std::vector<std::string>& paths) {
+        paths.push_back("~");
+    }
+
+    /// Write the inputs used by the handler other than the event (e.g. the
+    /// state of the GUI buttons that it looks at) to the stream, and return
+    /// true.  The TEventChangeManager only runs the handler when the event
+    /// or these inputs have changed, and otherwise leaves the Eve elements
+    /// from the last time it ran.  The default returns false so that the
+    /// handler is run every time.
+    virtual bool AddInputs(std::ostream& inputs) {return false;}
+
+    /// Get the lock that protects gGeoManager (e.g. the navigator used by
+    /// FindNode()) when it's used by Build().
+    static TMutex& GetGeometryLock();
+
+    /// Check if the update that is running Build() has been cancelled (e.g.
+    /// the user moved to another event).  Build() should check this in its
+    /// long loops and return early.  The partial result is never committed.
+    bool IsCancelled() const {
+        return fBuildGroup && fBuildGroup->IsCancelled();
+    }
+
+    /// Set the group of the task running Build() so that IsCancelled()
+    /// follows the cancellation of that group (see
+    /// CP::TTaskPool::Cancel()).  This is called by the TEventChangeManager
+    /// before Build(), and is cleared (NULL) afterwards.  A handler is only
+    /// built by one update at a time.
+    void SetBuildGroup(const CP::TTaskPool::Group* group) {
+        fBuildGroup = group;
+    }
+
+private:
+    /// The group of the task running Build(), or NULL.
+    const CP::TTaskPool::Group* fBuildGroup;
 };
 #endif
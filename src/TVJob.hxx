@@ -0,0 +1,39 @@
+#ifndef TVJob_hxx_seen
+#define TVJob_hxx_seen
+
+#include <string>
+
+namespace CP {
+    class TVJob;
+};
+
+/// A base class for a long operation (e.g. drawing an event) that is run
+/// without blocking the ROOT event loop.  The job is owned by the
+/// CP::TEventChangeManager (see CP::TEventChangeManager::AddJob()), which
+/// calls Step() from a GUI timer until the job is finished.  The slow work
+/// is done by CP::TVTask objects in the CP::TTaskPool, and the results are
+/// posted to a CP::TResultQueue that is emptied by Step() on the main
+/// thread.
+class CP::TVJob {
+public:
+    TVJob() {}
+    virtual ~TVJob() {}
+
+    /// Do the next piece of the work on the main thread.  This should return
+    /// after about "seconds" so that the GUI stays responsive, and returns
+    /// true when the job is finished.
+    virtual bool Step(double seconds) = 0;
+
+    /// Stop the job.  This is called on the main thread, and must wait for
+    /// the tasks that the job submitted to the pool.  The job is deleted
+    /// after it has been cancelled.
+    virtual void Cancel() = 0;
+
+    /// Get the name of the job shown in the GUI.  A new job replaces a
+    /// running job with the same name.
+    virtual std::string GetName() const = 0;
+
+    /// Get the fraction of the work that has been done.
+    virtual double GetProgress() const = 0;
+};
+#endif
@@ -0,0 +1,30 @@
+#ifndef TVSkimPredicate_hxx_seen
+#define TVSkimPredicate_hxx_seen
+
+#include <string>
+
+namespace CP {
+    class TVSkimPredicate;
+    class TEvent;
+};
+
+/// A base class for the selections used by CP::TEventSkim.  A predicate
+/// looks at an event and decides if it should be shown while the skim is
+/// active.  The predicate is applied by the skim worker threads to events
+/// that are not in the CP::TEventFolder, so it must only look at the event
+/// that it is given (e.g. it must not use CP::TEventFolder::GetCurrentEvent()
+/// or the GUI).  The same predicate is used by several threads at once, so
+/// Select() must not change the state of the predicate.
+class CP::TVSkimPredicate {
+public:
+    TVSkimPredicate() {}
+    virtual ~TVSkimPredicate() {}
+
+    /// Return true if the event should be shown.  Only the folders needed to
+    /// make the decision should be looked at.
+    virtual bool Select(CP::TEvent& event) const = 0;
+
+    /// Return a short description of the selection for the GUI.
+    virtual std::string GetDescription() const = 0;
+};
+#endif
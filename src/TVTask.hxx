@@ -0,0 +1,44 @@
+#ifndef TVTask_hxx_seen
+#define TVTask_hxx_seen
+
+#include "TTaskPool.hxx"
+
+#include <string>
+
+namespace CP {
+    class TVTask;
+};
+
+/// A base class for a piece of work run by CP::TTaskPool.  A task is run on
+/// one of the pool threads (or on a thread waiting for the task), so it must
+/// not use the GUI or gEve.  A task may submit more tasks (subtasks) to the
+/// pool and wait for them.  The pool deletes the task after it has run.
+class CP::TVTask {
+public:
+    TVTask() : fGroup(NULL) {}
+    virtual ~TVTask() {}
+
+    /// Do the work.
+    virtual void Execute() = 0;
+
+    /// Return the name used to collect the timing of the task.  Tasks doing
+    /// the same kind of work should have the same name.
+    virtual std::string GetName() const = 0;
+
+    /// Check if the group the task was submitted to has been cancelled (see
+    /// CP::TTaskPool::Cancel()).  A long task should check this in its loops
+    /// and return early when it's true.
+    bool IsCancelled() const {return fGroup && fGroup->IsCancelled();}
+
+    /// Get the group the task was submitted to, or NULL if the task hasn't
+    /// been submitted.
+    const CP::TTaskPool::Group* GetGroup() const {return fGroup;}
+
+private:
+    friend class CP::TTaskPool;
+
+    /// The group the task was submitted to.  This is set by
+    /// CP::TTaskPool::Submit().
+    const CP::TTaskPool::Group* fGroup;
+};
+#endif